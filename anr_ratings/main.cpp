@@ -7,7 +7,9 @@
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 #include <iostream>
+#include <stdexcept>
 
 string8_t GameToString(uint8_t score1, uint8_t score2)
 {
@@ -135,17 +137,43 @@ void ConvertLogs(const string8_t& rawLogDir, const string8_t& logDir, const stri
 	}
 }
 
-int main()
+// Usage: anr_ratings [--top count] [--intervals numReplays] [--remove-stale]
+// --top limits rating_active.csv to the best active players of that many.
+// --intervals also writes bootstrap intervals of the overall Elo ratings; they are off by default, since every replay costs a full Elo pass.
+// --remove-stale deletes the CSV files that the previous run wrote and this one did not.
+int main(int argc, char* argv[])
 {
 	try
 	{
+		my::ratings::CalculationSettings settings = my::ratings::StandartCalculationSettings();
+		for (int i = 1; i < argc; ++i)
+		{
+			string8_t option = argv[i];
+			if (option == "--top" && i + 1 < argc)
+			{
+				settings.m_activeRatingSize = boost::lexical_cast<uint32_t>(argv[++i]);
+			}
+			else if (option == "--intervals" && i + 1 < argc)
+			{
+				settings.m_numIntervalReplays = boost::lexical_cast<uint32_t>(argv[++i]);
+			}
+			else if (option == "--remove-stale")
+			{
+				settings.m_removeStaleFiles = true;
+			}
+			else
+			{
+				throw std::runtime_error("Unknown option " + option);
+			}
+		}
+
 		string8_t rawLogDir = "raw_logs";
 		string8_t rawLogBackupDir = "raw_logs_backup";
 		string8_t logDir = "logs";
 		string8_t rootDir = ".";
 
 		ConvertLogs(rawLogDir, logDir, rawLogBackupDir);
-		my::ratings::CalculateRatings(logDir, rootDir);
+		my::ratings::CalculateRatings(logDir, rootDir, settings);
 	}
 	catch (std::exception& e)
 	{
@@ -0,0 +1,26 @@
+#include <backtest.h>
+#include <boost/lexical_cast.hpp>
+#include <iostream>
+
+// Usage: elo_backtest [logDir] [numRandomSamples]
+// Without a sample count it runs the grid search.
+int main(int argc, char* argv[])
+{
+	try
+	{
+		string8_t logDir = (argc > 1 ? argv[1] : "logs");
+		uint32_t numSamples = (argc > 2 ? boost::lexical_cast<uint32_t>(argv[2]) : 0);
+		string8_t reportDir = ".";
+
+		my::ratings::ParameterRange fullChange(1, 100, 991);
+		my::ratings::EloSearchSpace space(fullChange, numSamples, 1);
+		my::ratings::BacktestEloSettings(logDir, space, reportDir);
+	}
+	catch (std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
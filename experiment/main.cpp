@@ -1,25 +1,22 @@
 #include <framework/rtl/expect.h>
+#include <framework/rtl/formatting.h>
 #include <framework/types/vector.h>
 #include <framework/types/string.h>
 #include <framework/types/types.h>
-#include <boost/range/algorithm/find.hpp>
-#include <boost/range/algorithm/find_if.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <algorithm>
+#include <stdexcept>
 #include <iostream>
+#include <cmath>
 
 namespace my {
 
-template<typename ProbabilityType, typename ObjectType>
-struct ProbabilityObject
-{
-	ProbabilityObject() { }
-	ProbabilityObject(const ProbabilityType& probability, const ObjectType& object) : m_probability(probability), m_object(object) { }
-
-	ProbabilityType m_probability;
-	ObjectType m_object;
-};
-
 const uint32_t ByeTag = -1;
 
 struct SwissTournament
@@ -85,7 +82,7 @@ public:
 		{
 			return 1;
 		}
-		else if (ByeTag == loser)
+		else if (ByeTag == winner)
 		{
 			return 0;
 		}
@@ -102,6 +99,17 @@ public:
 		return m_players[player].m_power;
 	}
 
+	const string8_t& GetName(uint32_t player) const
+	{
+		EXPECT(player < m_players.size());
+		return m_players[player].m_name;
+	}
+
+	uint32_t GetCount() const
+	{
+		return m_players.size();
+	}
+
 private:
 	double CalculateProbability(double winner, double loser) const
 	{
@@ -114,11 +122,6 @@ private:
 
 struct TournamentResult
 {
-	bool operator==(const TournamentResult& rhv) const
-	{
-		return false;
-	}
-
 	double m_maxPowerDifference;
 };
 
@@ -142,106 +145,512 @@ TournamentResult CalculateResult(const MatchResolver& resolver, const SwissTourn
 	return result;
 }
 
-bool CreatePairings(const vector<SwissTournament::Score>& players_, const vector<SwissTournament::Match>& prevPairings, vector<vector<SwissTournament::Match> >& possiblePairings)
+// SplitMix64 over (key, counter): the numbers of a simulation depend only on the seed and its index,
+// so the results do not depend on the number of threads or on which thread played it.
+class CounterRandom
 {
-	if (players_.empty())
-		return true;
+public:
+	explicit CounterRandom(uint64_t seed, uint64_t stream)
+		: m_key(Mix(seed ^ Mix(stream + Golden)))
+		, m_counter(0)
+	{
+	}
+
+public:
+	uint64_t Next()
+	{
+		return Mix(m_key + Golden * ++m_counter);
+	}
+
+	double NextDouble()
+	{
+		return (Next() >> 11) * (1./9007199254740992.);
+	}
+
+	uint32_t NextIndex(uint32_t count)
+	{
+		return uint32_t(((Next() >> 32) * count) >> 32);
+	}
+
+private:
+	static uint64_t Mix(uint64_t value)
+	{
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+
+private:
+	static const uint64_t Golden = 0x9E3779B97F4A7C15ULL;
+	const uint64_t m_key;
+	uint64_t m_counter;
+};
+
+struct SimulationSettings
+{
+	uint32_t m_numRounds;
+	uint32_t m_topCut;
+	uint64_t m_seed;
+	uint32_t m_batchSize;
+	uint64_t m_maxSimulations;
+	// Simulation stops once the standard error of every top cut probability is below it.
+	double m_tolerance;
+};
+
+// Plays one Swiss event: players with equal scores are paired in random order, top down, without rematches;
+// the bye goes to the lowest placed player who had none. Final standings are ordered by score,
+// then by the sum of the opponents' scores, then randomly.
+class SwissSimulation
+{
+public:
+	explicit SwissSimulation(const MatchResolver& resolver)
+		: m_resolver(resolver)
+		, m_players(resolver.GetPlayers())
+		, m_numSlots(m_players.size())
+		, m_numRounds(0)
+	{
+	}
+
+public:
+	void Play(uint32_t numRounds, CounterRandom& random, SwissTournament& tournament, vector<uint32_t>& places)
+	{
+		m_numRounds = numRounds;
+		m_scores.assign(m_numSlots, 0);
+		m_played.assign(m_numSlots * m_numSlots, false);
+		m_opponents.assign(m_numSlots * numRounds, 0);
+		tournament.m_pairs.clear();
+		for (uint32_t round = 0; round < numRounds; ++round)
+		{
+			Order(random);
+			m_pairs.clear();
+			m_isPaired.assign(m_numSlots, false);
+			if (!Pair(0, false))
+			{
+				m_pairs.clear();
+				m_isPaired.assign(m_numSlots, false);
+				EXPECT(Pair(0, true));
+			}
+			BOOST_FOREACH(const SwissTournament::Match& match, m_pairs)
+			{
+				PlayMatch(match, round, random);
+				tournament.m_pairs.push_back(match);
+			}
+		}
+		Rank(random, tournament, places);
+	}
 
-	vector<SwissTournament::Score> players = players_;
-	SwissTournament::Score mainPlayer = players[0];
-	players.erase(players.begin());
-	EXPECT(!players.empty());
+private:
+	// Score, opponents' score and a random tie break packed from the high bits down.
+	struct Entry
+	{
+		uint64_t m_key;
+		uint32_t m_slot;
 
-	vector<uint32_t> scores;
-	BOOST_FOREACH(const SwissTournament::Score& player, players)
+		bool operator<(const Entry& right) const
+		{
+			return m_key > right.m_key;
+		}
+	};
+
+private:
+	uint32_t GetSlot(uint32_t player) const
 	{
-		uint32_t currentScore = player.m_score;
-		if (boost::find(scores, currentScore) == scores.end())
+		return player == ByeTag ? m_numSlots - 1 : player;
+	}
+
+	// Counting sort by score, then a shuffle of every score group; the bye stays last.
+	void Order(CounterRandom& random)
+	{
+		m_groupsBegin.assign(m_numRounds + 3, 0);
+		for (uint32_t slot = 0; slot < m_numSlots; ++slot)
+		{
+			++m_groupsBegin[GetGroup(slot) + 1];
+		}
+		for (uint32_t group = 1; group < m_groupsBegin.size(); ++group)
+		{
+			m_groupsBegin[group] += m_groupsBegin[group - 1];
+		}
+
+		m_order.resize(m_numSlots);
+		m_groupsEnd = m_groupsBegin;
+		for (uint32_t slot = 0; slot < m_numSlots; ++slot)
 		{
-			scores.push_back(currentScore);
+			m_order[m_groupsEnd[GetGroup(slot)]++] = slot;
 		}
+		for (uint32_t group = 0; group + 1 < m_groupsBegin.size(); ++group)
+		{
+			uint32_t begin = m_groupsBegin[group];
+			for (uint32_t i = m_groupsBegin[group + 1]; i > begin + 1; --i)
+			{
+				std::swap(m_order[i - 1], m_order[begin + random.NextIndex(i - begin)]);
+			}
+		}
+	}
+
+	uint32_t GetGroup(uint32_t slot) const
+	{
+		return m_players[slot] == ByeTag ? m_numRounds + 1 : m_numRounds - m_scores[slot];
 	}
 
-	size_t playerIt = 0;
-	BOOST_FOREACH(uint32_t score, scores)
+	bool Pair(uint32_t first, bool allowRematches)
 	{
-		bool pairingsDone = false;
-		for (; playerIt < players.size(); ++playerIt)
+		while (first < m_numSlots && m_isPaired[m_order[first]])
 		{
-			if (players[playerIt].m_score != score)
-				break;
+			++first;
+		}
+		if (first == m_numSlots)
+			return true;
 
-			vector<SwissTournament::Score> currentPlayers = players;
-			currentPlayers.erase(currentPlayers.begin() + playerIt);
-			vector<vector<SwissTournament::Match> > currentPossiblePairings;
-			if (!CreatePairings(currentPlayers, prevPairings, currentPossiblePairings))
+		uint32_t slotA = m_order[first];
+		m_isPaired[slotA] = true;
+		for (uint32_t second = first + 1; second < m_numSlots; ++second)
+		{
+			uint32_t slotB = m_order[second];
+			if (m_isPaired[slotB] || (!allowRematches && m_played[slotA * m_numSlots + slotB]))
 				continue;
 
-			pairingsDone = true;
-			SwissTournament::Match currentMatch;
-			currentMatch.m_first = mainPlayer.m_name;
-			currentMatch.m_second = players[playerIt].m_name;
-			BOOST_FOREACH(vector<SwissTournament::Match>& newPairings, currentPossiblePairings)
+			m_isPaired[slotB] = true;
+			SwissTournament::Match match;
+			match.m_first = m_players[slotA];
+			match.m_second = m_players[slotB];
+			m_pairs.push_back(match);
+			if (Pair(first + 1, allowRematches))
+				return true;
+
+			m_pairs.pop_back();
+			m_isPaired[slotB] = false;
+		}
+		m_isPaired[slotA] = false;
+		return false;
+	}
+
+	void PlayMatch(const SwissTournament::Match& match, uint32_t round, CounterRandom& random)
+	{
+		uint32_t slotA = GetSlot(match.m_first);
+		uint32_t slotB = GetSlot(match.m_second);
+		m_played[slotA * m_numSlots + slotB] = true;
+		m_played[slotB * m_numSlots + slotA] = true;
+		m_opponents[slotA * m_numRounds + round] = slotB;
+		m_opponents[slotB * m_numRounds + round] = slotA;
+
+		bool isFirstWinner = (random.NextDouble() < m_resolver.ProbabilityOfWin(match.m_first, match.m_second));
+		++m_scores[isFirstWinner ? slotA : slotB];
+	}
+
+	void Rank(CounterRandom& random, SwissTournament& tournament, vector<uint32_t>& places)
+	{
+		uint32_t numPlayers = m_resolver.GetCount();
+		m_entries.resize(numPlayers);
+		for (uint32_t player = 0; player < numPlayers; ++player)
+		{
+			uint64_t opponentsScore = 0;
+			for (uint32_t round = 0; round < m_numRounds; ++round)
 			{
-				newPairings.push_back(currentMatch);
-				possiblePairings.push_back(newPairings);
+				uint32_t opponent = m_opponents[player * m_numRounds + round];
+				opponentsScore += (m_players[opponent] == ByeTag ? 0 : m_scores[opponent]);
 			}
+			m_entries[player].m_key = (uint64_t(m_scores[player]) << 48) | (opponentsScore << 32) | (random.Next() >> 32);
+			m_entries[player].m_slot = player;
 		}
+		std::sort(m_entries.begin(), m_entries.end());
 
-		if (pairingsDone)
-			break;
+		tournament.m_scores.resize(numPlayers);
+		places.resize(numPlayers);
+		for (uint32_t place = 0; place < numPlayers; ++place)
+		{
+			uint32_t player = m_entries[place].m_slot;
+			tournament.m_scores[place].m_name = player;
+			tournament.m_scores[place].m_score = m_scores[player];
+			places[player] = place;
+		}
 	}
 
-	return !possiblePairings.empty();
-}
+private:
+	const MatchResolver& m_resolver;
+	const vector<uint32_t> m_players;
+	const uint32_t m_numSlots;
+	uint32_t m_numRounds;
+	vector<uint32_t> m_scores;
+	vector<uint8_t> m_played;
+	vector<uint32_t> m_opponents;
+	vector<uint32_t> m_groupsBegin;
+	vector<uint32_t> m_groupsEnd;
+	vector<uint32_t> m_order;
+	vector<Entry> m_entries;
+	vector<uint8_t> m_isPaired;
+	vector<SwissTournament::Match> m_pairs;
+};
 
-typedef ProbabilityObject<double, SwissTournament> ProbabilityOfTournament; 
-vector<ProbabilityOfTournament> RunTour(const vector<ProbabilityOfTournament>& prevTours, const MatchResolver& resolver, size_t numOfTours, const vector<SwissTournament::Match>& pairings)
+// Every worker owns a range of task indices and takes small chunks from its front;
+// an idle worker steals the back half of the first non-empty range of another worker.
+class WorkStealingPool
 {
-	EXPECT(numOfTours > 0);
+public:
+	explicit WorkStealingPool(uint32_t numWorkers)
+		: m_numWorkers(numWorkers)
+	{
+		for (uint32_t i = 0; i < numWorkers; ++i)
+		{
+			m_ranges.push_back(new Range());
+		}
+	}
 
+public:
+	uint32_t GetNumWorkers() const
+	{
+		return m_numWorkers;
+	}
 
-	/*
-	BOOST_FOREACH(const ProbabilityOfTournament& prevTour, prevTours)
+	// Runs task(worker, index) for every index in [begin, end).
+	void Run(uint64_t begin, uint64_t end, const boost::function<void (uint32_t, uint64_t)>& task)
 	{
-		EXPECT(CreatePairings(prevTour.m_object.m_scores, prevTour.m_object.m_pairs, ));
+		for (uint32_t worker = 0; worker < m_numWorkers; ++worker)
+		{
+			m_ranges[worker].m_begin = begin + (end - begin) * worker/m_numWorkers;
+			m_ranges[worker].m_end = begin + (end - begin) * (worker + 1)/m_numWorkers;
+		}
+		m_error.clear();
+
+		boost::thread_group threads;
+		for (uint32_t worker = 0; worker < m_numWorkers; ++worker)
+		{
+			threads.create_thread(boost::bind(&WorkStealingPool::Work, this, worker, boost::cref(task)));
+		}
+		threads.join_all();
+		if (!m_error.empty())
+			throw std::runtime_error(m_error);
 	}
-	*/
 
-	vector<ProbabilityOfTournament> results;
-}
+private:
+	struct Range
+	{
+		boost::mutex m_mutex;
+		uint64_t m_begin;
+		uint64_t m_end;
+	};
+
+	static const uint64_t ChunkSize = 64;
+
+private:
+	void Work(uint32_t worker, const boost::function<void (uint32_t, uint64_t)>& task)
+	{
+		uint64_t begin = 0;
+		uint64_t end = 0;
+		try
+		{
+			while (Pop(worker, begin, end) || (Steal(worker) && Pop(worker, begin, end)))
+			{
+				for (uint64_t index = begin; index < end; ++index)
+				{
+					task(worker, index);
+				}
+			}
+		}
+		catch (std::exception& e)
+		{
+			boost::mutex::scoped_lock lock(m_errorMutex);
+			if (m_error.empty())
+			{
+				m_error = e.what();
+			}
+		}
+	}
+
+	bool Pop(uint32_t worker, uint64_t& begin, uint64_t& end)
+	{
+		Range& range = m_ranges[worker];
+		boost::mutex::scoped_lock lock(range.m_mutex);
+		if (range.m_begin == range.m_end)
+			return false;
+
+		begin = range.m_begin;
+		end = std::min(range.m_end, begin + ChunkSize);
+		range.m_begin = end;
+		return true;
+	}
 
-typedef ProbabilityObject<double, TournamentResult> ProbabilityOfResult;
-vector<ProbabilityOfResult> RunTournament(const MatchResolver& resolver, size_t numOfTours, const vector<SwissTournament::Match>& startPairings)
+	bool Steal(uint32_t worker)
+	{
+		for (uint32_t offset = 1; offset < m_numWorkers; ++offset)
+		{
+			uint64_t begin = 0;
+			uint64_t end = 0;
+			{
+				Range& victim = m_ranges[(worker + offset) % m_numWorkers];
+				boost::mutex::scoped_lock lock(victim.m_mutex);
+				if (victim.m_begin == victim.m_end)
+					continue;
+
+				end = victim.m_end;
+				begin = (victim.m_end - victim.m_begin > ChunkSize ? victim.m_begin + (victim.m_end - victim.m_begin)/2 : victim.m_begin);
+				victim.m_end = begin;
+			}
+
+			Range& range = m_ranges[worker];
+			boost::mutex::scoped_lock lock(range.m_mutex);
+			range.m_begin = begin;
+			range.m_end = end;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	const uint32_t m_numWorkers;
+	boost::ptr_vector<Range> m_ranges;
+	boost::mutex m_errorMutex;
+	string8_t m_error;
+};
+
+// Plays the event in batches until the top cut probabilities converge.
+// Places are counted per worker and the per-simulation results are summed in index order, so the report is reproducible.
+class MonteCarloSwiss
 {
-	vector<ProbabilityOfTournament> startTournament;
-	startTournament.push_back(ProbabilityOfTournament(1, SwissTournament()));
-	vector<ProbabilityOfTournament> results = RunTour(startTournament, resolver, numOfTours, startPairings);
-	vector<ProbabilityOfResult> calculatedResults;
-
-	double normalization = 0;
-	BOOST_FOREACH(const ProbabilityOfTournament& node, results)
-	{
-		normalization += node.m_probability;
-		TournamentResult currentResult = CalculateResult(resolver, node.m_object);
-		vector<ProbabilityOfResult>::iterator it = boost::find_if(calculatedResults, boost::bind(&ProbabilityOfResult::m_object, _1) == currentResult);
-		if (it == calculatedResults.end())
+public:
+	explicit MonteCarloSwiss(const MatchResolver& resolver, const SimulationSettings& settings, WorkStealingPool& pool)
+		: m_resolver(resolver)
+		, m_settings(settings)
+		, m_pool(pool)
+		, m_numPlayers(resolver.GetCount())
+		, m_numSimulations(0)
+		, m_sumMaxPowerDifference(0)
+		, m_sumSquaredMaxPowerDifference(0)
+	{
+		for (uint32_t worker = 0; worker < pool.GetNumWorkers(); ++worker)
 		{
-			calculatedResults.push_back(ProbabilityOfResult(node.m_probability, currentResult));
+			m_workers.push_back(new Worker(resolver, m_numPlayers));
 		}
-		else
+	}
+
+public:
+	void Run()
+	{
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		while (m_numSimulations < m_settings.m_maxSimulations)
 		{
-			it->m_probability += node.m_probability;
+			uint64_t batchSize = std::min<uint64_t>(m_settings.m_batchSize, m_settings.m_maxSimulations - m_numSimulations);
+			m_maxPowerDifferences.resize(batchSize);
+			m_pool.Run(m_numSimulations, m_numSimulations + batchSize, boost::bind(&MonteCarloSwiss::Simulate, this, _1, _2));
+			BOOST_FOREACH(double difference, m_maxPowerDifferences)
+			{
+				m_sumMaxPowerDifference += difference;
+				m_sumSquaredMaxPowerDifference += difference * difference;
+			}
+			m_numSimulations += batchSize;
+
+			double maxError = GetMaxTopCutError();
+			int64_t microseconds = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+			std::cout << ToString(m_numSimulations) + " simulations, max power difference " + ToString(GetMean(), StandartPrintDigitsAfterDot) + " +/- " + ToString(GetMeanError(), StandartPrintDigitsAfterDot)
+				+ ", top cut max error " + ToString(maxError, 5) + ", " + ToString(microseconds/1000000., StandartPrintDigitsAfterDot) + " s\n";
+			if (maxError < m_settings.m_tolerance)
+				break;
 		}
 	}
 
-	for (vector<ProbabilityOfResult>::iterator it = calculatedResults.begin(); it != calculatedResults.end(); ++it)
+	void Report() const
 	{
-		it->m_probability /= normalization;
+		vector<uint64_t> placeCounts = GetPlaceCounts();
+
+		std::cout << "player, power, expected place, win, top " + ToString(m_settings.m_topCut) + "\n";
+		for (uint32_t player = 0; player < m_numPlayers; ++player)
+		{
+			double expectedPlace = 0;
+			for (uint32_t place = 0; place < m_numPlayers; ++place)
+			{
+				expectedPlace += double(place + 1) * placeCounts[uint64_t(player) * m_numPlayers + place]/m_numSimulations;
+			}
+			std::cout << m_resolver.GetName(player) + ", " + ToString(m_resolver.GetPower(player), StandartPrintDigitsAfterDot) + ", " + ToString(expectedPlace, 2) + ", "
+				+ ToString(double(placeCounts[uint64_t(player) * m_numPlayers])/m_numSimulations, 4) + ", " + ToString(GetTopCutProbability(placeCounts, player), 4) + "\n";
+		}
 	}
 
-	return calculatedResults;
-}
+private:
+	struct Worker
+	{
+		Worker(const MatchResolver& resolver, uint32_t numPlayers)
+			: m_simulation(resolver)
+			, m_placeCounts(uint64_t(numPlayers) * numPlayers, 0)
+		{
+		}
+
+		SwissSimulation m_simulation;
+		SwissTournament m_tournament;
+		vector<uint32_t> m_places;
+		vector<uint64_t> m_placeCounts;
+	};
+
+private:
+	void Simulate(uint32_t workerIndex, uint64_t simulation)
+	{
+		Worker& worker = m_workers[workerIndex];
+		CounterRandom random(m_settings.m_seed, simulation);
+		worker.m_simulation.Play(m_settings.m_numRounds, random, worker.m_tournament, worker.m_places);
+		for (uint32_t player = 0; player < m_numPlayers; ++player)
+		{
+			++worker.m_placeCounts[uint64_t(player) * m_numPlayers + worker.m_places[player]];
+		}
+		m_maxPowerDifferences[simulation - m_numSimulations] = CalculateResult(m_resolver, worker.m_tournament).m_maxPowerDifference;
+	}
+
+	double GetTopCutProbability(const vector<uint64_t>& placeCounts, uint32_t player) const
+	{
+		uint64_t count = 0;
+		for (uint32_t place = 0; place < std::min(m_settings.m_topCut, m_numPlayers); ++place)
+		{
+			count += placeCounts[uint64_t(player) * m_numPlayers + place];
+		}
+		return double(count)/m_numSimulations;
+	}
+
+	vector<uint64_t> GetPlaceCounts() const
+	{
+		vector<uint64_t> placeCounts(uint64_t(m_numPlayers) * m_numPlayers, 0);
+		BOOST_FOREACH(const Worker& worker, m_workers)
+		{
+			for (size_t i = 0; i < placeCounts.size(); ++i)
+			{
+				placeCounts[i] += worker.m_placeCounts[i];
+			}
+		}
+		return placeCounts;
+	}
+
+	double GetMaxTopCutError() const
+	{
+		vector<uint64_t> placeCounts = GetPlaceCounts();
+
+		double maxError = 0;
+		for (uint32_t player = 0; player < m_numPlayers; ++player)
+		{
+			double probability = GetTopCutProbability(placeCounts, player);
+			maxError = std::max(maxError, sqrt(probability * (1 - probability)/m_numSimulations));
+		}
+		return maxError;
+	}
+
+	double GetMean() const
+	{
+		return m_sumMaxPowerDifference/m_numSimulations;
+	}
+
+	double GetMeanError() const
+	{
+		double mean = GetMean();
+		double variance = std::max(0., m_sumSquaredMaxPowerDifference/m_numSimulations - mean * mean);
+		return sqrt(variance/m_numSimulations);
+	}
+
+private:
+	const MatchResolver& m_resolver;
+	const SimulationSettings m_settings;
+	WorkStealingPool& m_pool;
+	const uint32_t m_numPlayers;
+	uint64_t m_numSimulations;
+	boost::ptr_vector<Worker> m_workers;
+	vector<double> m_maxPowerDifferences;
+	double m_sumMaxPowerDifference;
+	double m_sumSquaredMaxPowerDifference;
+};
 
 } // namespace my
 
@@ -252,17 +661,30 @@ int main(int argc, char** argv)
 
 	try
 	{
+		const double powers[] = {
+			1180.711, 1167.978, 1147.523, 1141.609, 1126.794, 1112.624, 1112.408, 1111.836, 1108.133, 1096.025,
+			1088.048, 1079.548, 1077.368, 1069.291, 1054.502, 1054.120, 1051.342, 1044.663, 1042.820, 1042.687,
+			1040.589, 1039.148, 1036.162, 1035.029, 1027.940, 1019.469, 1018.514, 1017.585, 1016.293, 1015.918,
+			1015.690, 1011.902, 1010.917, 1010.190, 1010.190, 1009.576, 1009.360, 1008.339, 1008.079, 1006.812};
 		vector<MatchResolver::Player> players;
-		players.push_back(MatchResolver::Player("1", 1180.980));
-		players.push_back(MatchResolver::Player("20", 1042.590));
-		players.push_back(MatchResolver::Player("35", 1010.190));
-		players.push_back(MatchResolver::Player("58", 987.512));
-		players.push_back(MatchResolver::Player("70", 981.125));
-		players.push_back(MatchResolver::Player("90", 971.199));
-		players.push_back(MatchResolver::Player("116", 859.498));
+		for (uint32_t i = 0; i < sizeof(powers)/sizeof(powers[0]); ++i)
+		{
+			players.push_back(MatchResolver::Player(ToString(i + 1), powers[i]));
+		}
+
+		SimulationSettings settings;
+		settings.m_numRounds = 6;
+		settings.m_topCut = 8;
+		settings.m_seed = 1;
+		settings.m_batchSize = 100000;
+		settings.m_maxSimulations = 10000000;
+		settings.m_tolerance = 0.0005;
 
 		MatchResolver resolver(players);
-		vector<ProbabilityObject<double, TournamentResult> > results = RunTournament(resolver, 3, vector<SwissTournament::Match>());
+		WorkStealingPool pool(std::max(1u, boost::thread::hardware_concurrency()));
+		MonteCarloSwiss simulator(resolver, settings, pool);
+		simulator.Run();
+		simulator.Report();
 	}
 	catch (std::exception& e)
 	{
@@ -271,4 +693,4 @@ int main(int argc, char** argv)
 	}
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,41 @@
+#ifndef _44E28B70_70E1_4725_92D6_82E9AFB36047_
+#define _44E28B70_70E1_4725_92D6_82E9AFB36047_
+
+#include <framework/types/string.h>
+#include <framework/types/types.h>
+
+namespace my {
+namespace ratings {
+
+struct ParameterRange
+{
+	ParameterRange(double minValue, double maxValue, uint32_t numValues);
+
+	double m_minValue;
+	double m_maxValue;
+	uint32_t m_numValues;
+};
+
+// A grid search takes m_numValues evenly spaced values of the range; a random search (numSamples != 0)
+// draws numSamples values uniformly from it instead.
+// Predictions depend only on fullChange * log(logisticPowerBase)/logisticRatingDenominator, so the base and the denominator
+// stay at the standard values and only the full change is searched: fullChange at the standard denominator D0 predicts
+// exactly like fullChange * D/D0 at a denominator D.
+struct EloSearchSpace
+{
+	EloSearchSpace(const ParameterRange& fullChange, uint32_t numSamples, uint32_t seed);
+
+	ParameterRange m_fullChange;
+	uint32_t m_numSamples;
+	uint32_t m_seed;
+};
+
+// Replays the logs under every settings of the search space, predicting each match before it is rated.
+// Writes reportDir/backtest.csv with log-loss, Brier score and calibration error, best settings first,
+// and reportDir/calibration.csv with the calibration table of the best settings.
+void BacktestEloSettings(const string8_t& logDir, const EloSearchSpace& space, const string8_t& reportDir);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _44E28B70_70E1_4725_92D6_82E9AFB36047_
@@ -2,11 +2,60 @@
 #define _7950F5E1_6B35_45B9_B005_838FC014A29A_
 
 #include <framework/types/string.h>
+#include <framework/types/types.h>
 
 namespace my {
 namespace ratings {
 
-void CalculateRatings(const string8_t& logDir, const string8_t& rootDir);
+enum ProcessingMode
+{
+	InMemoryProcessing,
+	StreamingProcessing
+};
+
+enum OutputFormat
+{
+	CsvOutput,
+	ArchiveOutput
+};
+
+// A row of history.csv is "rank, name:rating, ..., name:rating,rank": the player holding the rank after every tournament,
+// under one header line ", tournament, ..., tournament,". DenseHistory leaves the cells of the tournaments played before
+// anyone held the rank empty. SparseHistory adds a "first" column after the rank, with the number of the first tournament
+// the row has a cell for, and leaves the empty cells out: a reader shifts the cells of a row right by first - 1 to line them
+// up with the header. It saves two bytes per empty cell but adds a few per row, so files are only a few percent smaller.
+enum HistoryLayout
+{
+	DenseHistory,
+	SparseHistory
+};
+
+const uint32_t AllPlayers = -1;
+
+// m_activeRatingSize limits rating_active.csv to the best players of that many; AllPlayers keeps every active player.
+// With m_numIntervalReplays != 0 the logs are also replayed that many times, every tournament with a resample of its own matches,
+// and the 95% percentile intervals of every player's final Elo rating and rank go to ratings/elo/overall/rating_intervals.csv.
+// m_removeStaleFiles deletes the CSV files that the previous run wrote and this one did not, such as players that left a view.
+struct CalculationSettings
+{
+	CalculationSettings(ProcessingMode mode, OutputFormat format, HistoryLayout layout, uint32_t activeRatingSize, uint32_t numIntervalReplays,
+		bool removeStaleFiles);
+
+	ProcessingMode m_mode;
+	OutputFormat m_format;
+	HistoryLayout m_layout;
+	uint32_t m_activeRatingSize;
+	uint32_t m_numIntervalReplays;
+	bool m_removeStaleFiles;
+};
+
+// In memory, CSV files, dense history, every active player, no intervals and no removal of stale files.
+CalculationSettings StandartCalculationSettings();
+
+void CalculateRatings(const string8_t& logDir, const string8_t& rootDir, const CalculationSettings& settings);
+
+// Writes the files of rootDir/ratings.archive back as the CSV tree that CsvOutput would have written under rootDir/ratings.
+void ExtractArchive(const string8_t& rootDir);
 
 } // namespace ratings
 } // namespace my
@@ -0,0 +1,98 @@
+#include "activity.h"
+#include <framework/rtl/expect.h>
+#include <boost/foreach.hpp>
+
+namespace my {
+namespace ratings {
+
+void ActivityTracker::Add(const Tournament& tournament)
+{
+	if (tournament.m_playerIds.empty())
+		return;
+
+	m_tournamentTags.clear();
+	BOOST_FOREACH(const string8_t& tag, tournament.m_tags)
+	{
+		uint32_t tagId = GetTagId(tag);
+		m_lastTournaments[tagId] = tournament.m_date;
+		m_tournamentTags.push_back(tagId);
+	}
+
+	BOOST_FOREACH(PlayerId player, tournament.m_playerIds)
+	{
+		EXPECT(player != InvalidPlayerId);
+		if (player >= m_playerTags.size())
+		{
+			m_playerTags.resize(player + 1);
+		}
+
+		vector<PlayerTag>& playerTags = m_playerTags[player];
+		if (playerTags.empty())
+		{
+			m_players.push_back(player);
+		}
+
+		BOOST_FOREACH(uint32_t tagId, m_tournamentTags)
+		{
+			vector<PlayerTag>::iterator it = playerTags.begin();
+			while (it != playerTags.end() && it->m_tag != tagId)
+			{
+				++it;
+			}
+
+			if (it != playerTags.end())
+			{
+				it->m_date = tournament.m_date;
+			}
+			else
+			{
+				PlayerTag playerTag;
+				playerTag.m_tag = tagId;
+				playerTag.m_date = tournament.m_date;
+				playerTags.push_back(playerTag);
+			}
+		}
+	}
+}
+
+vector<PlayerId> ActivityTracker::GetActivePlayers(const boost::gregorian::date_duration& timeout) const
+{
+	vector<PlayerId> result;
+	BOOST_FOREACH(PlayerId player, m_players)
+	{
+		BOOST_FOREACH(const PlayerTag& playerTag, m_playerTags[player])
+		{
+			if ((m_lastTournaments[playerTag.m_tag] - timeout) < playerTag.m_date)
+			{
+				result.push_back(player);
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+uint32_t ActivityTracker::GetTagId(const string8_t& tag)
+{
+	boost::unordered_map<string8_t, uint32_t>::const_iterator it = m_tagIds.find(tag);
+	if (it != m_tagIds.end())
+		return it->second;
+
+	uint32_t tagId = m_lastTournaments.size();
+	m_tagIds[tag] = tagId;
+	m_lastTournaments.push_back(boost::gregorian::date());
+	return tagId;
+}
+
+vector<PlayerId> GetActivePlayers(boost::gregorian::date_duration& timeout, const vector<Tournament>& tournaments)
+{
+	ActivityTracker activity;
+	BOOST_FOREACH(const Tournament& tournament, tournaments)
+	{
+		activity.Add(tournament);
+	}
+	return activity.GetActivePlayers(timeout);
+}
+
+} // namespace ratings
+} // namespace my
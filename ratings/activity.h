@@ -0,0 +1,45 @@
+#ifndef _532F9D52_84A8_4F0A_8214_61D295C4AEC8_
+#define _532F9D52_84A8_4F0A_8214_61D295C4AEC8_
+
+#include "tournament.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace my {
+namespace ratings {
+
+// Running "last seen" dates of every player per tag, fed one tournament at a time in date order.
+// A player is active while their last game under some tag is within the timeout of the last tournament with that tag.
+// Tags are interned on first use, so Add() costs O(participants * tags of the tournament).
+class ActivityTracker
+{
+public:
+	void Add(const Tournament& tournament);
+	vector<PlayerId> GetActivePlayers(const boost::gregorian::date_duration& timeout) const;
+
+private:
+	struct PlayerTag
+	{
+		uint32_t m_tag;
+		boost::gregorian::date m_date;
+	};
+
+private:
+	uint32_t GetTagId(const string8_t& tag);
+
+private:
+	boost::unordered_map<string8_t, uint32_t> m_tagIds;
+	vector<boost::gregorian::date> m_lastTournaments;
+	vector<PlayerId> m_players;
+	vector<vector<PlayerTag> > m_playerTags;
+	vector<uint32_t> m_tournamentTags;
+};
+
+vector<PlayerId> GetActivePlayers(boost::gregorian::date_duration& timeout, const vector<Tournament>& tournaments);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _532F9D52_84A8_4F0A_8214_61D295C4AEC8_
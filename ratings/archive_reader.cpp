@@ -0,0 +1,62 @@
+#include "archive_reader.h"
+#include "binary.h"
+#include <framework/rtl/expect.h>
+#include <algorithm>
+#include <cstring>
+
+namespace my {
+namespace ratings {
+namespace {
+
+bool IsLess(const ArchiveEntry& left, const ArchiveEntry& right)
+{
+	if (left.m_view != right.m_view)
+		return left.m_view < right.m_view;
+	return left.m_name < right.m_name;
+}
+
+} // namespace
+
+ArchiveReader::ArchiveReader(const string8_t& archiveFile)
+	: m_file(archiveFile.c_str(), boost::interprocess::read_only)
+	, m_region(m_file, boost::interprocess::read_only)
+{
+	const char* data = static_cast<const char*>(m_region.get_address());
+	BinaryReader reader(data, data + m_region.get_size());
+
+	EXPECT(memcmp(reader.Skip(sizeof(ArchiveMagic)), ArchiveMagic, sizeof(ArchiveMagic)) == 0);
+	EXPECT(reader.Read<uint32_t>() == ArchiveVersion);
+	uint32_t numEntries = reader.Read<uint32_t>();
+	m_entries.resize(numEntries);
+	for (uint32_t i = 0; i < numEntries; ++i)
+	{
+		ArchiveEntry& entry = m_entries[i];
+		entry.m_view = reader.ReadString();
+		entry.m_name = reader.ReadString();
+		uint64_t offset = reader.Read<uint64_t>();
+		entry.m_size = reader.Read<uint64_t>();
+		EXPECT(offset <= m_region.get_size() && entry.m_size <= m_region.get_size() - offset);
+		entry.m_data = data + offset;
+		EXPECT(i == 0 || IsLess(m_entries[i - 1], entry));
+	}
+}
+
+const vector<ArchiveEntry>& ArchiveReader::GetEntries() const
+{
+	return m_entries;
+}
+
+const ArchiveEntry* ArchiveReader::Find(const string8_t& view, const string8_t& name) const
+{
+	ArchiveEntry key;
+	key.m_view = view;
+	key.m_name = name;
+	vector<ArchiveEntry>::const_iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), key, &IsLess);
+	if (it == m_entries.end() || it->m_view != view || it->m_name != name)
+		return 0;
+
+	return &*it;
+}
+
+} // namespace ratings
+} // namespace my
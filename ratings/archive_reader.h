@@ -0,0 +1,45 @@
+#ifndef _3FDB3B63_5D36_4F41_BF15_A19307284EC0_
+#define _3FDB3B63_5D36_4F41_BF15_A19307284EC0_
+
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace my {
+namespace ratings {
+
+const char ArchiveMagic[] = "LCGRARC";
+const uint32_t ArchiveVersion = 2;
+
+struct ArchiveEntry
+{
+	string8_t m_view;
+	string8_t m_name;
+	const char* m_data;
+	uint64_t m_size;
+};
+
+// Index of an archive saved by ArchiveWriter, read from a memory mapping; entry data stays valid while the reader lives.
+class ArchiveReader
+{
+public:
+	explicit ArchiveReader(const string8_t& archiveFile);
+
+public:
+	// Sorted by view and name.
+	const vector<ArchiveEntry>& GetEntries() const;
+	// Returns 0 if the archive has no such file.
+	const ArchiveEntry* Find(const string8_t& view, const string8_t& name) const;
+
+private:
+	boost::interprocess::file_mapping m_file;
+	boost::interprocess::mapped_region m_region;
+	vector<ArchiveEntry> m_entries;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _3FDB3B63_5D36_4F41_BF15_A19307284EC0_
@@ -0,0 +1,205 @@
+#include "archive_writer.h"
+#include "archive_reader.h"
+#include "binary.h"
+#include <framework/rtl/formatting.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const string8_t PlayersDir = "players";
+
+} // namespace
+
+// Every part goes to the data file at once; an entry that is never closed is left out of the archive.
+class ArchiveWriter::Stream: public IOutputStream
+{
+public:
+	explicit Stream(ArchiveWriter& writer, uint32_t entry)
+		: m_writer(writer)
+		, m_entry(entry)
+	{
+	}
+
+public:
+	void Write(string8_t& text)
+	{
+		m_writer.AppendPart(m_entry, text);
+	}
+
+	void Close()
+	{
+		m_writer.CloseEntry(m_entry);
+	}
+
+private:
+	ArchiveWriter& m_writer;
+	const uint32_t m_entry;
+};
+
+ArchiveWriter::ArchiveWriter(const string8_t& archiveFile, const string8_t& outputDir)
+	: m_archiveFile(archiveFile)
+	, m_dataFilePath(archiveFile + ".tmp")
+	, m_outputDir(outputDir + "/")
+	, m_dataFile(new system::File(m_dataFilePath, system::file_access_rights::Write, system::file_creation::CreateAlways))
+	, m_dataSize(0)
+	, m_numFiles(0)
+	, m_archiveSize(0)
+	, m_microseconds(0)
+{
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+	m_dataFile.reset();
+	boost::system::error_code error;
+	boost::filesystem::remove(m_dataFilePath, error);
+}
+
+void ArchiveWriter::Write(const string8_t& /*phase*/, const string8_t& filePath, string8_t& text)
+{
+	uint32_t entry = AddEntry(filePath);
+	AppendPart(entry, text);
+	CloseEntry(entry);
+}
+
+std::auto_ptr<IOutputStream> ArchiveWriter::Open(const string8_t& /*phase*/, const string8_t& filePath)
+{
+	return std::auto_ptr<IOutputStream>(new Stream(*this, AddEntry(filePath)));
+}
+
+void ArchiveWriter::Flush()
+{
+	using namespace boost::interprocess;
+
+	boost::mutex::scoped_lock lock(m_mutex);
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+	vector<Entry> entries;
+	BOOST_FOREACH(const Entry& entry, m_entries)
+	{
+		if (entry.m_isClosed)
+		{
+			entries.push_back(entry);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), &ArchiveWriter::IsLess);
+
+	// Offsets of the contents follow from the size of the index, which is known before any content is copied.
+	uint64_t offset = sizeof(ArchiveMagic) + sizeof(ArchiveVersion) + sizeof(uint32_t);
+	BOOST_FOREACH(const Entry& entry, entries)
+	{
+		offset += sizeof(uint32_t) + entry.m_view.size() + sizeof(uint32_t) + entry.m_name.size() + 2 * sizeof(uint64_t);
+	}
+
+	string8_t text(ArchiveMagic, ArchiveMagic + sizeof(ArchiveMagic));
+	Append(text, ArchiveVersion);
+	Append(text, uint32_t(entries.size()));
+	BOOST_FOREACH(const Entry& entry, entries)
+	{
+		AppendString(text, entry.m_view);
+		AppendString(text, entry.m_name);
+		Append(text, offset);
+		Append(text, entry.m_size);
+		offset += entry.m_size;
+	}
+
+	system::File archive(m_archiveFile, system::file_access_rights::Write, system::file_creation::CreateAlways);
+	archive.Write(text);
+	m_dataFile.reset();
+	if (m_dataSize != 0)
+	{
+		file_mapping dataFile(m_dataFilePath.c_str(), read_only);
+		mapped_region data(dataFile, read_only);
+		const char* begin = static_cast<const char*>(data.get_address());
+		BOOST_FOREACH(const Entry& entry, entries)
+		{
+			BOOST_FOREACH(const Part& part, entry.m_parts)
+			{
+				text.assign(begin + part.first, begin + part.first + part.second);
+				archive.Write(text);
+			}
+		}
+	}
+	boost::system::error_code error;
+	boost::filesystem::remove(m_dataFilePath, error);
+
+	m_numFiles = entries.size();
+	m_archiveSize = offset;
+	m_microseconds = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+}
+
+string8_t ArchiveWriter::GetReport() const
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	return "archive: " + ToString(m_numFiles) + " files, " + ToString(m_archiveSize) + " bytes, " + ToString(m_microseconds/1000000., StandartPrintDigitsAfterDot) + " s\n";
+}
+
+uint32_t ArchiveWriter::AddEntry(const string8_t& filePath)
+{
+	string8_t relativePath = filePath;
+	if (boost::starts_with(relativePath, m_outputDir))
+	{
+		relativePath.erase(0, m_outputDir.size());
+	}
+	size_t separator = relativePath.rfind('/');
+	// Player files belong to the view of the directory that holds their players dir.
+	if (separator != string8_t::npos)
+	{
+		string8_t directory = relativePath.substr(0, separator);
+		if (directory == PlayersDir)
+		{
+			separator = string8_t::npos;
+		}
+		else if (boost::ends_with(directory, "/" + PlayersDir))
+		{
+			separator -= PlayersDir.size() + 1;
+		}
+	}
+
+	Entry entry;
+	entry.m_view = (separator == string8_t::npos ? string8_t() : relativePath.substr(0, separator));
+	entry.m_name = (separator == string8_t::npos ? relativePath : relativePath.substr(separator + 1));
+	entry.m_size = 0;
+	entry.m_isClosed = false;
+
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_entries.push_back(entry);
+	return m_entries.size() - 1;
+}
+
+void ArchiveWriter::AppendPart(uint32_t entry, string8_t& text)
+{
+	if (!text.empty())
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_dataFile->Write(text);
+		m_entries[entry].m_parts.push_back(Part(m_dataSize, text.size()));
+		m_entries[entry].m_size += text.size();
+		m_dataSize += text.size();
+	}
+	text.clear();
+}
+
+void ArchiveWriter::CloseEntry(uint32_t entry)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_entries[entry].m_isClosed = true;
+}
+
+bool ArchiveWriter::IsLess(const Entry& left, const Entry& right)
+{
+	if (left.m_view != right.m_view)
+		return left.m_view < right.m_view;
+	return left.m_name < right.m_name;
+}
+
+} // namespace ratings
+} // namespace my
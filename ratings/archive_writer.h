@@ -0,0 +1,72 @@
+#ifndef _D7253269_F3D8_4EC4_878A_9F9D9D2C0BA8_
+#define _D7253269_F3D8_4EC4_878A_9F9D9D2C0BA8_
+
+#include "output.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+#include <framework/system/file.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <utility>
+
+namespace my {
+namespace ratings {
+
+// Collects all output files into one archive saved by Flush():
+// magic, version, number of entries, index of (view, name, offset, size) sorted by view and name, file contents in index order.
+// The view is the directory of a rating relative to the output dir, such as "elo/overall", and the name is the path of a file
+// inside it, such as "rating.csv" or "players/<player>.csv". Offsets are counted from the start of the archive,
+// so readers can use the index of a memory-mapped archive directly.
+// Contents go to a temporary data file as they come, and Flush() copies them from it behind the index,
+// so neither the files nor the archive are ever held in memory.
+class ArchiveWriter: public IOutput
+{
+public:
+	explicit ArchiveWriter(const string8_t& archiveFile, const string8_t& outputDir);
+	~ArchiveWriter();
+
+public:
+	void Write(const string8_t& phase, const string8_t& filePath, string8_t& text);
+	std::auto_ptr<IOutputStream> Open(const string8_t& phase, const string8_t& filePath);
+	void Flush();
+	string8_t GetReport() const;
+
+private:
+	class Stream;
+
+	// Offset and size of a part of the file in the data file.
+	typedef std::pair<uint64_t, uint64_t> Part;
+
+	struct Entry
+	{
+		string8_t m_view;
+		string8_t m_name;
+		vector<Part> m_parts;
+		uint64_t m_size;
+		bool m_isClosed;
+	};
+
+private:
+	uint32_t AddEntry(const string8_t& filePath);
+	void AppendPart(uint32_t entry, string8_t& text);
+	void CloseEntry(uint32_t entry);
+	static bool IsLess(const Entry& left, const Entry& right);
+
+private:
+	const string8_t m_archiveFile;
+	const string8_t m_dataFilePath;
+	const string8_t m_outputDir;
+	mutable boost::mutex m_mutex;
+	boost::scoped_ptr<system::File> m_dataFile;
+	vector<Entry> m_entries;
+	uint64_t m_dataSize;
+	uint64_t m_numFiles;
+	uint64_t m_archiveSize;
+	int64_t m_microseconds;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _D7253269_F3D8_4EC4_878A_9F9D9D2C0BA8_
@@ -0,0 +1,190 @@
+#include <backtest.h>
+#include "match_dataset.h"
+#include "elo.h"
+#include "parallel.h"
+#include "text_format.h"
+#include <framework/system/file.h>
+#include <framework/rtl/expect.h>
+#include <framework/rtl/formatting.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const uint32_t NumCalibrationBins = 10;
+const double MinProbability = 1e-12;
+const int MetricDigitsAfterDot = 6;
+
+struct Result
+{
+	double m_logLoss;
+	double m_brierScore;
+	double m_calibrationError;
+	uint32_t m_binCounts[NumCalibrationBins];
+	double m_binPredicted[NumCalibrationBins];
+	double m_binObserved[NumCalibrationBins];
+};
+
+vector<double> GetValues(const ParameterRange& range)
+{
+	vector<double> values;
+	for (uint32_t i = 0; i < range.m_numValues; ++i)
+	{
+		values.push_back(range.m_numValues == 1 ? range.m_minValue : range.m_minValue + (range.m_maxValue - range.m_minValue) * i/(range.m_numValues - 1));
+	}
+	return values;
+}
+
+vector<EloSettings> GetSettings(const EloSearchSpace& space)
+{
+	const EloSettings standart = StandartEloSettings();
+	vector<EloSettings> result;
+	if (space.m_numSamples == 0)
+	{
+		BOOST_FOREACH(double fullChange, GetValues(space.m_fullChange))
+		{
+			result.push_back(EloSettings(standart.m_startRating, fullChange, standart.m_logisticPowerBase, standart.m_logisticRatingDenominator));
+		}
+	}
+	else
+	{
+		boost::random::mt19937 generator(space.m_seed);
+		boost::random::uniform_real_distribution<double> fullChange(space.m_fullChange.m_minValue, space.m_fullChange.m_maxValue);
+		for (uint32_t i = 0; i < space.m_numSamples; ++i)
+		{
+			result.push_back(EloSettings(standart.m_startRating, fullChange(generator), standart.m_logisticPowerBase, standart.m_logisticRatingDenominator));
+		}
+	}
+	return result;
+}
+
+// Same update as EloTournament::AddMatch, with pow() folded into a single exp() and no history kept.
+void BacktestTask(const MatchDataset& dataset, const vector<EloSettings>& settings, vector<Result>& results, size_t index)
+{
+	const EloSettings& current = settings[index];
+	const double exponentFactor = log(current.m_logisticPowerBase)/current.m_logisticRatingDenominator;
+	vector<double> ratings(dataset.m_numPlayers, current.m_startRating);
+
+	Result result = Result();
+	uint32_t numMatches = dataset.GetNumMatches();
+	for (uint32_t match = 0; match < numMatches; ++match)
+	{
+		double& ratingA = ratings[dataset.m_players[2 * match]];
+		double& ratingB = ratings[dataset.m_players[2 * match + 1]];
+		double score = dataset.m_scores[match];
+		double expectation = 1./(1. + exp((ratingB - ratingA) * exponentFactor));
+
+		double probability = std::min(std::max(expectation, MinProbability), 1. - MinProbability);
+		result.m_logLoss -= score * log(probability) + (1. - score) * log(1. - probability);
+		result.m_brierScore += (expectation - score) * (expectation - score);
+		uint32_t bin = std::min(uint32_t(expectation * NumCalibrationBins), NumCalibrationBins - 1);
+		++result.m_binCounts[bin];
+		result.m_binPredicted[bin] += expectation;
+		result.m_binObserved[bin] += score;
+
+		double changeOfRating = current.m_fullChange * dataset.m_weights[match] * (score - expectation);
+		ratingA += changeOfRating;
+		ratingB -= changeOfRating;
+	}
+
+	if (numMatches != 0)
+	{
+		result.m_logLoss /= numMatches;
+		result.m_brierScore /= numMatches;
+		for (uint32_t bin = 0; bin < NumCalibrationBins; ++bin)
+		{
+			result.m_calibrationError += fabs(result.m_binPredicted[bin] - result.m_binObserved[bin])/numMatches;
+		}
+	}
+	results[index] = result;
+}
+
+bool IsBetter(const vector<Result>& results, uint32_t left, uint32_t right)
+{
+	return results[left].m_logLoss < results[right].m_logLoss;
+}
+
+} // namespace
+
+ParameterRange::ParameterRange(double minValue, double maxValue, uint32_t numValues)
+	: m_minValue(minValue)
+	, m_maxValue(maxValue)
+	, m_numValues(numValues)
+{
+	EXPECT(m_minValue <= m_maxValue);
+	EXPECT(m_numValues != 0);
+}
+
+EloSearchSpace::EloSearchSpace(const ParameterRange& fullChange, uint32_t numSamples, uint32_t seed)
+	: m_fullChange(fullChange)
+	, m_numSamples(numSamples)
+	, m_seed(seed)
+{
+}
+
+void BacktestEloSettings(const string8_t& logDir, const EloSearchSpace& space, const string8_t& reportDir)
+{
+	PlayerRegistry players;
+	MatchDataset dataset = ReadMatchDataset(logDir, players);
+	vector<EloSettings> settings = GetSettings(space);
+
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	vector<Result> results(settings.size());
+	ParallelFor(settings.size(), boost::bind(&BacktestTask, boost::cref(dataset), boost::cref(settings), boost::ref(results), _1));
+	int64_t microseconds = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+
+	vector<uint32_t> order(settings.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), boost::bind(&IsBetter, boost::cref(results), _1, _2));
+
+	string8_t text = "fullChange, logLoss, brierScore, calibrationError\n";
+	BOOST_FOREACH(uint32_t i, order)
+	{
+		AppendFixed(text, settings[i].m_fullChange, StandartPrintDigitsAfterDot);
+		text += ", ";
+		AppendFixed(text, results[i].m_logLoss, MetricDigitsAfterDot);
+		text += ", ";
+		AppendFixed(text, results[i].m_brierScore, MetricDigitsAfterDot);
+		text += ", ";
+		AppendFixed(text, results[i].m_calibrationError, MetricDigitsAfterDot);
+		text += '\n';
+	}
+	system::SaveToFile(reportDir + "/backtest.csv", text);
+
+	if (order.empty())
+		return;
+
+	const Result& best = results[order.front()];
+	text = "bin, matches, predicted, observed\n";
+	for (uint32_t bin = 0; bin < NumCalibrationBins; ++bin)
+	{
+		uint32_t count = best.m_binCounts[bin];
+		AppendInteger(text, bin);
+		text += ", ";
+		AppendInteger(text, count);
+		text += ", ";
+		AppendFixed(text, count == 0 ? 0. : best.m_binPredicted[bin]/count, MetricDigitsAfterDot);
+		text += ", ";
+		AppendFixed(text, count == 0 ? 0. : best.m_binObserved[bin]/count, MetricDigitsAfterDot);
+		text += '\n';
+	}
+	system::SaveToFile(reportDir + "/calibration.csv", text);
+
+	std::cout << ToString(uint32_t(settings.size())) + " settings, " + ToString(dataset.GetNumMatches()) + " matches, " + ToString(microseconds/1000000., StandartPrintDigitsAfterDot) + " s\n";
+	std::cout << "best: fullChange " + ToString(settings[order.front()].m_fullChange, StandartPrintDigitsAfterDot)
+		+ ", logLoss " + ToString(best.m_logLoss, MetricDigitsAfterDot) + ", brierScore " + ToString(best.m_brierScore, MetricDigitsAfterDot) + ", calibrationError " + ToString(best.m_calibrationError, MetricDigitsAfterDot) + "\n";
+}
+
+} // namespace ratings
+} // namespace my
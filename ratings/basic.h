@@ -2,13 +2,17 @@
 #define _0B9ABFA5_F96D_40CE_B1C3_E545A1470892_
 
 #include <framework/types/string.h>
+#include <framework/types/types.h>
 
 namespace my {
 namespace ratings {
 
+typedef uint32_t PlayerId;
+const PlayerId InvalidPlayerId = -1;
+
 struct Rating
 {
-	string8_t player;
+	PlayerId player;
 	double value;
 };
 
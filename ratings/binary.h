@@ -0,0 +1,89 @@
+#ifndef _46799943_CB34_4511_A1E8_4B4A03A3C1DB_
+#define _46799943_CB34_4511_A1E8_4B4A03A3C1DB_
+
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+#include <framework/rtl/expect.h>
+#include <cstring>
+
+namespace my {
+namespace ratings {
+
+template<typename ValueType>
+void Append(string8_t& output, const ValueType& value)
+{
+	output.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void AppendString(string8_t& output, const string8_t& text)
+{
+	Append(output, uint32_t(text.size()));
+	output += text;
+}
+
+template<typename ValueType>
+void AppendVector(string8_t& output, const vector<ValueType>& values)
+{
+	Append(output, uint32_t(values.size()));
+	if (!values.empty())
+	{
+		output.append(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(ValueType));
+	}
+}
+
+class BinaryReader
+{
+public:
+	BinaryReader(const char* begin, const char* end) : m_current(begin), m_end(end) { }
+
+public:
+	template<typename ValueType>
+	ValueType Read()
+	{
+		ValueType value;
+		memcpy(&value, Skip(sizeof(value)), sizeof(value));
+		return value;
+	}
+
+	string8_t ReadString()
+	{
+		uint32_t size = Read<uint32_t>();
+		const char* data = Skip(size);
+		return string8_t(data, data + size);
+	}
+
+	template<typename ValueType>
+	void ReadVector(vector<ValueType>& values)
+	{
+		uint32_t size = Read<uint32_t>();
+		const char* data = Skip(size_t(size) * sizeof(ValueType));
+		values.resize(size);
+		if (size != 0)
+		{
+			memcpy(&values[0], data, size_t(size) * sizeof(ValueType));
+		}
+	}
+
+	const char* Skip(size_t size)
+	{
+		EXPECT(size_t(m_end - m_current) >= size);
+		const char* data = m_current;
+		m_current += size;
+		return data;
+	}
+
+	bool IsEnd() const
+	{
+		return m_current == m_end;
+	}
+
+private:
+	const char* m_current;
+	const char* const m_end;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _46799943_CB34_4511_A1E8_4B4A03A3C1DB_
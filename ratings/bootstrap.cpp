@@ -0,0 +1,200 @@
+#include "bootstrap.h"
+#include "elo.h"
+#include "output.h"
+#include "parallel.h"
+#include "text_format.h"
+#include <framework/rtl/formatting.h>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/seed_seq.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const uint32_t BootstrapSeed = 1;
+const double LowPercentile = 0.025;
+const double HighPercentile = 0.975;
+const uint32_t BootstrapBlockCells = 1 << 22;
+
+bool IsHigher(const vector<double>& ratings, PlayerId left, PlayerId right)
+{
+	return ratings[left] > ratings[right] || (ratings[left] == ratings[right] && left < right);
+}
+
+void GetRanking(const vector<double>& ratings, vector<PlayerId>& order)
+{
+	order.resize(ratings.size());
+	for (PlayerId player = 0; player < order.size(); ++player)
+	{
+		order[player] = player;
+	}
+	std::sort(order.begin(), order.end(), boost::bind(&IsHigher, boost::cref(ratings), _1, _2));
+}
+
+// Ratings and ranks that the players of a block of rows of the ranking get in every replay, one row of values per replay.
+// Every replay seeds its own generator from its index, so the result does not depend on the number of workers.
+class Bootstrap
+{
+public:
+	explicit Bootstrap(const MatchDataset& dataset, const EloSettings& settings, const vector<Rating>& ranking, uint32_t numReplays)
+		: m_dataset(dataset)
+		, m_settings(settings)
+		, m_ranking(ranking)
+		, m_numReplays(numReplays)
+		, m_blockBegin(0)
+		, m_blockSize(0)
+	{
+	}
+
+public:
+	void Run(uint32_t blockBegin, uint32_t blockEnd)
+	{
+		m_blockBegin = blockBegin;
+		m_blockSize = blockEnd - blockBegin;
+		m_ratings.resize(uint64_t(m_numReplays) * m_blockSize);
+		m_ranks.resize(uint64_t(m_numReplays) * m_blockSize);
+		uint32_t numChunks = std::min(GetNumWorkers(), m_numReplays);
+		ParallelFor(numChunks, boost::bind(&Bootstrap::ReplayChunk, this, numChunks, _1));
+	}
+
+	void GetInterval(uint32_t row, double& ratingLow, double& ratingHigh, uint32_t& rankLow, uint32_t& rankHigh) const
+	{
+		vector<float> ratings(m_numReplays);
+		vector<uint32_t> ranks(m_numReplays);
+		for (uint32_t replay = 0; replay < m_numReplays; ++replay)
+		{
+			ratings[replay] = m_ratings[uint64_t(replay) * m_blockSize + row - m_blockBegin];
+			ranks[replay] = m_ranks[uint64_t(replay) * m_blockSize + row - m_blockBegin];
+		}
+		ratingLow = GetPercentile(ratings, LowPercentile);
+		ratingHigh = GetPercentile(ratings, HighPercentile);
+		rankLow = GetPercentile(ranks, LowPercentile);
+		rankHigh = GetPercentile(ranks, HighPercentile);
+	}
+
+private:
+	// Every tournament plays a resample of its own matches, in order.
+	void Replay(boost::random::mt19937& generator, vector<double>& ratings, vector<uint32_t>& sample) const
+	{
+		const double exponentFactor = log(m_settings.m_logisticPowerBase)/m_settings.m_logisticRatingDenominator;
+		ratings.assign(m_dataset.m_numPlayers, m_settings.m_startRating);
+		uint32_t begin = 0;
+		BOOST_FOREACH(uint32_t end, m_dataset.m_tournamentsEnd)
+		{
+			sample.clear();
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				sample.push_back(boost::random::uniform_int_distribution<uint32_t>(begin, end - 1)(generator));
+			}
+			std::sort(sample.begin(), sample.end());
+
+			BOOST_FOREACH(uint32_t match, sample)
+			{
+				double& ratingA = ratings[m_dataset.m_players[2 * match]];
+				double& ratingB = ratings[m_dataset.m_players[2 * match + 1]];
+				double score = m_dataset.m_scores[match];
+				double expectation = 1./(1. + exp((ratingB - ratingA) * exponentFactor));
+				double changeOfRating = m_settings.m_fullChange * m_dataset.m_weights[match] * (score - expectation);
+				ratingA += changeOfRating;
+				ratingB -= changeOfRating;
+			}
+			begin = end;
+		}
+	}
+
+	void ReplayChunk(uint32_t numChunks, size_t chunk)
+	{
+		vector<double> ratings;
+		vector<uint32_t> sample;
+		vector<PlayerId> order;
+		vector<uint32_t> ranks(m_dataset.m_numPlayers);
+		for (uint32_t replay = uint64_t(m_numReplays) * chunk/numChunks; replay < uint64_t(m_numReplays) * (chunk + 1)/numChunks; ++replay)
+		{
+			uint32_t seeds[] = {BootstrapSeed, replay};
+			boost::random::seed_seq sequence(seeds, seeds + 2);
+			boost::random::mt19937 generator(sequence);
+			Replay(generator, ratings, sample);
+
+			GetRanking(ratings, order);
+			for (uint32_t i = 0; i < order.size(); ++i)
+			{
+				ranks[order[i]] = i + 1;
+			}
+			uint64_t row = uint64_t(replay) * m_blockSize;
+			for (uint32_t i = 0; i < m_blockSize; ++i)
+			{
+				PlayerId player = m_ranking[m_blockBegin + i].player;
+				m_ratings[row + i] = float(ratings[player]);
+				m_ranks[row + i] = ranks[player];
+			}
+		}
+	}
+
+	template<typename ValueType>
+	static ValueType GetPercentile(vector<ValueType>& values, double percentile)
+	{
+		typename vector<ValueType>::iterator it = values.begin() + uint32_t(percentile * (values.size() - 1) + 0.5);
+		std::nth_element(values.begin(), it, values.end());
+		return *it;
+	}
+
+private:
+	const MatchDataset& m_dataset;
+	const EloSettings& m_settings;
+	const vector<Rating>& m_ranking;
+	const uint32_t m_numReplays;
+	uint32_t m_blockBegin;
+	uint32_t m_blockSize;
+	vector<float> m_ratings;
+	vector<uint32_t> m_ranks;
+};
+
+} // namespace
+
+void DumpRatingIntervals(const MatchDataset& dataset, const EloSettings& settings, const vector<Rating>& ratings, const PlayerRegistry& players,
+	uint32_t numReplays, const string8_t& ratingFile, IOutput& writer)
+{
+	if (numReplays == 0 || ratings.empty())
+		return;
+
+	// Every block replays all the resamples again, so a block is as large as the memory budget allows.
+	uint32_t blockSize = std::max<uint32_t>(BootstrapBlockCells/numReplays, 1);
+	Bootstrap bootstrap(dataset, settings, ratings, numReplays);
+	string8_t text = "rank, name, rating, ratingLow, ratingHigh, rankLow, rankHigh\n";
+	for (uint32_t blockBegin = 0; blockBegin < ratings.size(); blockBegin += blockSize)
+	{
+		uint32_t blockEnd = std::min<uint32_t>(blockBegin + blockSize, ratings.size());
+		bootstrap.Run(blockBegin, blockEnd);
+		for (uint32_t i = blockBegin; i < blockEnd; ++i)
+		{
+			double ratingLow = 0;
+			double ratingHigh = 0;
+			uint32_t rankLow = 0;
+			uint32_t rankHigh = 0;
+			bootstrap.GetInterval(i, ratingLow, ratingHigh, rankLow, rankHigh);
+			AppendInteger(text, i + 1);
+			text += ", ";
+			text += players.GetName(ratings[i].player);
+			text += ", ";
+			AppendFixed(text, ratings[i].value, StandartPrintDigitsAfterDot);
+			text += ", ";
+			AppendFixed(text, ratingLow, StandartPrintDigitsAfterDot);
+			text += ", ";
+			AppendFixed(text, ratingHigh, StandartPrintDigitsAfterDot);
+			text += ", ";
+			AppendInteger(text, rankLow);
+			text += ", ";
+			AppendInteger(text, rankHigh);
+			text += '\n';
+		}
+	}
+	writer.Write("intervals", ratingFile, text);
+}
+
+} // namespace ratings
+} // namespace my
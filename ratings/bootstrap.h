@@ -0,0 +1,23 @@
+#ifndef _A9260EE8_39F4_4CC6_8C47_B850B89175B4_
+#define _A9260EE8_39F4_4CC6_8C47_B850B89175B4_
+
+#include "basic.h"
+#include "match_dataset.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+
+namespace my {
+namespace ratings {
+
+struct IOutput;
+struct EloSettings;
+
+// Replays the dataset numReplays times, every tournament with a resample of its own matches, and writes the 95% percentile
+// intervals of the final Elo rating and rank of every player in ratings, which are the point estimates and their order.
+void DumpRatingIntervals(const MatchDataset& dataset, const EloSettings& settings, const vector<Rating>& ratings, const PlayerRegistry& players,
+	uint32_t numReplays, const string8_t& ratingFile, IOutput& writer);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _A9260EE8_39F4_4CC6_8C47_B850B89175B4_
\ No newline at end of file
@@ -1,9 +1,8 @@
 #include "elo.h"
 #include "history.h"
+#include "binary.h"
 #include <framework/rtl/expect.h>
-#include <framework/rtl/formatting.h>
-#include <boost/range/algorithm/find_if.hpp>
-#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
 
 namespace my {
@@ -16,44 +15,79 @@ public:
 	explicit RatingStorage(double startRating) : m_startRating(startRating) { }
 
 public:
-	double Get(const string8_t& player)
+	double Get(PlayerId player)
 	{
 		return GetInternal(player);
 	}
 
-	void Set(const string8_t& player, double newRating)
+	void Set(PlayerId player, double newRating)
 	{
 		GetInternal(player) = newRating;
+		if (!m_isChanged[player])
+		{
+			m_isChanged[player] = true;
+			m_changed.push_back(player);
+		}
 	}
 
-	vector<Rating> GetRatings()
+	vector<Rating> PopChanges()
 	{
-		vector<Rating> result = m_ratings;
-		std::sort(result.begin(), result.end(), boost::bind(&Rating::value, _1) > boost::bind(&Rating::value, _2));
+		vector<Rating> result;
+		result.reserve(m_changed.size());
+		BOOST_FOREACH(PlayerId player, m_changed)
+		{
+			Rating rating;
+			rating.player = player;
+			rating.value = m_ratings[player];
+			result.push_back(rating);
+			m_isChanged[player] = false;
+		}
+		m_changed.clear();
 		return result;
 	}
 
+	void Save(string8_t& output) const
+	{
+		vector<uint8_t> isRated(m_isRated.begin(), m_isRated.end());
+		AppendVector(output, m_ratings);
+		AppendVector(output, isRated);
+	}
+
+	void Load(BinaryReader& reader)
+	{
+		vector<uint8_t> isRated;
+		reader.ReadVector(m_ratings);
+		reader.ReadVector(isRated);
+		EXPECT(isRated.size() == m_ratings.size());
+		m_isRated.assign(isRated.begin(), isRated.end());
+		m_isChanged.assign(m_ratings.size(), false);
+		m_changed.clear();
+	}
+
 private:
-	double& GetInternal(const string8_t& player)
+	double& GetInternal(PlayerId player)
 	{
-		vector<Rating>::iterator it = boost::find_if(m_ratings, boost::bind(&Rating::player, _1) == player);
-		if (it != m_ratings.end())
+		if (player >= m_ratings.size())
 		{
-			return it->value;
+			m_ratings.resize(player + 1, 0);
+			m_isRated.resize(player + 1, false);
+			m_isChanged.resize(player + 1, false);
 		}
-		else
+
+		if (!m_isRated[player])
 		{
-			Rating newRating;
-			newRating.player = player;
-			newRating.value = m_startRating;
-			m_ratings.push_back(newRating);
-			return m_ratings.back().value;
+			m_isRated[player] = true;
+			m_ratings[player] = m_startRating;
 		}
+		return m_ratings[player];
 	}
 
 private:
 	const double m_startRating;
-	vector<Rating> m_ratings;
+	vector<double> m_ratings;
+	vector<bool> m_isRated;
+	vector<bool> m_isChanged;
+	vector<PlayerId> m_changed;
 };
 
 double ChangeOfRating(double myRating, double opponentRating, double score, double changeFactor, const EloSettings& settings)
@@ -63,11 +97,6 @@ double ChangeOfRating(double myRating, double opponentRating, double score, doub
 	return changeFactor * (score - scoreExpectation);
 }
 
-string8_t RatingChangeToString(double prevRating, double changeInRating)
-{
-	return "(" + ToString(prevRating, StandartPrintDigitsAfterDot) + (changeInRating > 0 ? " +" : " ") + ToString(changeInRating, StandartPrintDigitsAfterDot) +  ")";
-}
-
 } // namespace
 
 class EloTournament: public ITournament
@@ -82,23 +111,20 @@ public:
 	}
 
 public:
-	void AddMatch(const string8_t& playerA, const string8_t& playerB, uint32_t scoreA, uint32_t scoreB)
+	void AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB)
 	{
 		double ratingA = m_ratings.Get(playerA);
 		double ratingB = m_ratings.Get(playerB);
 		double totalScore = scoreA + scoreB;
 		double changeOfRating = ChangeOfRating(ratingA, ratingB, double(scoreA)/totalScore, totalScore * m_changeFactor, m_settings);
-		string8_t ratingTextA = RatingChangeToString(ratingA, changeOfRating);
-		string8_t ratingTextB = RatingChangeToString(ratingB, -changeOfRating);
-		m_tournamentHistory->AddRecord(playerA, ratingTextA + ", " + playerA + ", " + "(" + ToString(scoreA) + ") - (" + ToString(scoreB) + ")" + ", " + playerB + ", " + ratingTextB);
-		m_tournamentHistory->AddRecord(playerB, ratingTextB + ", " + playerB + ", " + "(" + ToString(scoreB) + ") - (" + ToString(scoreA) + ")" + ", " + playerA + ", " + ratingTextA);
+		m_tournamentHistory->AddMatch(playerA, playerB, scoreA, scoreB, ratingA, ratingB, changeOfRating, -changeOfRating);
 		m_ratings.Set(playerA, ratingA + changeOfRating);
 		m_ratings.Set(playerB, ratingB - changeOfRating);
 	}
 
 	void End()
 	{
-		m_tournamentHistory->End(m_ratings.GetRatings());
+		m_tournamentHistory->End(m_ratings.PopChanges());
 	}
 
 private:
@@ -111,8 +137,9 @@ private:
 class EloSeason: public ISeason
 {
 public:
-	explicit EloSeason(const EloSettings& settings)
+	explicit EloSeason(const EloSettings& settings, const PlayerRegistry& players)
 		: m_settings(settings)
+		, m_history(players)
 		, m_ratings(settings.m_startRating)
 	{
 	}
@@ -123,14 +150,44 @@ public:
 		return std::auto_ptr<ITournament>(new EloTournament(m_settings, pointsPerMatch, m_ratings, std::auto_ptr<HistoryStorage::Tournament>(new HistoryStorage::Tournament(m_history, name))));
 	}
 
-	void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir)
+	string8_t Update()
+	{
+		return string8_t();
+	}
+
+	void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir, HistoryLayout layout, IOutput& writer)
+	{
+		m_history.DumpHistory(ratingFile, ratingHistoryFile, playersDir, layout, writer);
+	}
+
+	vector<Rating> GetRatings() const
+	{
+		return m_history.GetRatings();
+	}
+
+	void DumpActiveRating(const string8_t& ratingFile, const vector<PlayerId>& activePlayers, uint32_t maxCount, IOutput& writer)
+	{
+		m_history.DumpActiveRating(ratingFile, activePlayers, maxCount, writer);
+	}
+
+	void Save(string8_t& output) const
 	{
-		m_history.DumpHistory(ratingFile, ratingHistoryFile, playersDir);
+		Append(output, m_settings.m_startRating);
+		Append(output, m_settings.m_fullChange);
+		Append(output, m_settings.m_logisticPowerBase);
+		Append(output, m_settings.m_logisticRatingDenominator);
+		m_ratings.Save(output);
+		m_history.Save(output);
 	}
 
-	void DumpActiveRating(const string8_t& ratingFile, const vector<string8_t>& activePlayers)
+	void Load(BinaryReader& reader)
 	{
-		m_history.DumpActiveRating(ratingFile, activePlayers);
+		EXPECT(reader.Read<double>() == m_settings.m_startRating);
+		EXPECT(reader.Read<double>() == m_settings.m_fullChange);
+		EXPECT(reader.Read<double>() == m_settings.m_logisticPowerBase);
+		EXPECT(reader.Read<double>() == m_settings.m_logisticRatingDenominator);
+		m_ratings.Load(reader);
+		m_history.Load(reader);
 	}
 
 private:
@@ -145,9 +202,9 @@ public:
 	explicit EloSystem(const EloSettings& settings) : m_settings(settings) { }
 
 public:
-	std::auto_ptr<ISeason> NewSeason()
+	std::auto_ptr<ISeason> NewSeason(const PlayerRegistry& players)
 	{
-		return std::auto_ptr<ISeason>(new EloSeason(m_settings));
+		return std::auto_ptr<ISeason>(new EloSeason(m_settings, players));
 	}
 
 private:
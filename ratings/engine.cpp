@@ -1,72 +1,327 @@
 #include "engine.h"
+#include "parallel.h"
+#include "binary.h"
+#include "hash.h"
+#include <framework/system/file.h>
 #include <framework/rtl/expect.h>
 #include <framework/rtl/formatting.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
 
 namespace my {
 namespace ratings {
 namespace {
 
-void GetScore(const vector<Game>& games, uint32_t& scoreA, uint32_t& scoreB)
+bool HasTag(const Tournament& tournament, const string8_t& tag)
 {
-	scoreA = 0;
-	scoreB = 0;
-	BOOST_FOREACH(const Game& game, games)
+	return std::find(tournament.m_tags.begin(), tournament.m_tags.end(), tag) != tournament.m_tags.end();
+}
+
+struct View
+{
+	View(ISeason& season, const string8_t& dir) : m_season(&season), m_dir(dir) { }
+
+	ISeason* m_season;
+	string8_t m_dir;
+	vector<uint32_t> m_tournaments;
+	string8_t m_report;
+};
+
+void PrintReports(const vector<View>& views)
+{
+	BOOST_FOREACH(const View& view, views)
+	{
+		if (!view.m_report.empty())
+		{
+			std::cout << (view.m_dir + ": " + view.m_report + "\n");
+		}
+	}
+}
+
+void UpdateTask(vector<View>& views, size_t index)
+{
+	View& view = views[index];
+	view.m_report = view.m_season->Update();
+}
+
+void PlayTask(vector<View>& views, const vector<Tournament>& tournaments, size_t index)
+{
+	View& view = views[index];
+	BOOST_FOREACH(uint32_t i, view.m_tournaments)
+	{
+		const Tournament& tournament = tournaments[i];
+		boost::scoped_ptr<ITournament> ratingTournament(view.m_season->NewTournament(tournament.m_name, tournament.m_pointsPerMatch).release());
+		for (uint32_t match = 0; match < tournament.GetNumMatches(); ++match)
+		{
+			PlayerId playerA = tournament.m_playerIds[tournament.m_matchPlayers[2 * match]];
+			PlayerId playerB = tournament.m_playerIds[tournament.m_matchPlayers[2 * match + 1]];
+			ratingTournament->AddMatch(playerA, playerB, tournament.m_matchScores[2 * match], tournament.m_matchScores[2 * match + 1]);
+		}
+		ratingTournament->End();
+	}
+	view.m_report = view.m_season->Update();
+}
+
+void DumpTask(const vector<View>& outputs, HistoryLayout layout, IOutput& writer, size_t index)
+{
+	const View& output = outputs[index];
+	output.m_season->DumpHistory(output.m_dir + "/rating.csv", output.m_dir + "/history.csv", output.m_dir + "/players", layout, writer);
+}
+
+const char Magic[] = "LCGCHKP";
+const uint32_t Version = 4;
+
+uint64_t CalculateTournamentsHash(const vector<Tournament>& tournaments, uint32_t count)
+{
+	uint64_t hash = CalculateHash(string8_t());
+	string8_t buffer;
+	for (uint32_t i = 0; i < count; ++i)
 	{
-		scoreA += game.m_score1;
-		scoreB += game.m_score2;
+		const Tournament& tournament = tournaments[i];
+		buffer.clear();
+		AppendString(buffer, tournament.m_name);
+		Append(buffer, uint16_t(tournament.m_date.year()));
+		Append(buffer, uint8_t(tournament.m_date.month()));
+		Append(buffer, uint8_t(tournament.m_date.day()));
+		Append(buffer, uint8_t(tournament.m_endOfSeason));
+		Append(buffer, tournament.m_pointsPerMatch);
+		Append(buffer, uint32_t(tournament.m_tags.size()));
+		BOOST_FOREACH(const string8_t& tag, tournament.m_tags)
+		{
+			AppendString(buffer, tag);
+		}
+		Append(buffer, uint32_t(tournament.m_players.size()));
+		BOOST_FOREACH(const Player& player, tournament.m_players)
+		{
+			AppendString(buffer, player.ToString());
+		}
+		AppendVector(buffer, tournament.m_matchPlayers);
+		AppendVector(buffer, tournament.m_gamesEnd);
+		AppendVector(buffer, tournament.m_gameScores);
+		hash = UpdateHash(hash, buffer.data(), buffer.size());
 	}
+	return hash;
 }
 
 } // namespace 
 
-Engine::Engine(const string8_t& name, std::auto_ptr<ISystem>& system)
+Engine::Engine(const string8_t& name, std::auto_ptr<ISystem>& system, const PlayerRegistry& players, const vector<string8_t>& tags)
 	: m_name(name)
+	, m_players(players)
 	, m_system(system)
+	, m_tags(tags)
+	, m_numTournaments(0)
+{
+	m_overallSeason.reset(m_system->NewSeason(m_players).release());
+	m_seasons.push_back(m_system->NewSeason(m_players).release());
+	for (uint32_t i = 0; i < m_tags.size(); ++i)
+	{
+		m_tagSeasons.push_back(m_system->NewSeason(m_players).release());
+	}
+}
+
+const string8_t& Engine::GetName() const
 {
-	m_overallSeason.reset(m_system->NewSeason().release());
-	m_seasons.push_back(m_system->NewSeason().release());
+	return m_name;
 }
 
 void Engine::ProcessTournament(const Tournament& tournament)
 {
-	boost::scoped_ptr<ITournament> overallTournament(m_overallSeason->NewTournament(tournament.m_name, tournament.m_pointsPerMatch));
-	boost::scoped_ptr<ITournament> seasonTournament(m_seasons.back().NewTournament(tournament.m_name, tournament.m_pointsPerMatch));
+	boost::ptr_vector<ITournament> views;
+	views.push_back(m_overallSeason->NewTournament(tournament.m_name, tournament.m_pointsPerMatch).release());
+	views.push_back(m_seasons.back().NewTournament(tournament.m_name, tournament.m_pointsPerMatch).release());
+	for (uint32_t i = 0; i < m_tags.size(); ++i)
+	{
+		if (HasTag(tournament, m_tags[i]))
+		{
+			views.push_back(m_tagSeasons[i].NewTournament(tournament.m_name, tournament.m_pointsPerMatch).release());
+		}
+	}
 
-	BOOST_FOREACH(const Match& match, tournament.m_matches)
+	for (uint32_t match = 0; match < tournament.GetNumMatches(); ++match)
 	{
-		string8_t playerA = match.m_player1.ToString();
-		string8_t playerB = match.m_player2.ToString();
-		uint32_t scoreA = 0;
-		uint32_t scoreB = 0;
-		GetScore(match.m_games, scoreA, scoreB);
-		overallTournament->AddMatch(playerA, playerB, scoreA, scoreB);
-		seasonTournament->AddMatch(playerA, playerB, scoreA, scoreB);
+		PlayerId playerA = tournament.m_playerIds[tournament.m_matchPlayers[2 * match]];
+		PlayerId playerB = tournament.m_playerIds[tournament.m_matchPlayers[2 * match + 1]];
+		uint32_t scoreA = tournament.m_matchScores[2 * match];
+		uint32_t scoreB = tournament.m_matchScores[2 * match + 1];
+		BOOST_FOREACH(ITournament& view, views)
+		{
+			view.AddMatch(playerA, playerB, scoreA, scoreB);
+		}
 	}
 
-	overallTournament->End();
-	seasonTournament->End();
+	BOOST_FOREACH(ITournament& view, views)
+	{
+		view.End();
+	}
 
 	if (tournament.m_endOfSeason)
 	{
-		m_seasons.push_back(m_system->NewSeason().release());
+		m_seasons.push_back(m_system->NewSeason(m_players).release());
 	}
+	++m_numTournaments;
 }
 
-void Engine::End(const vector<string8_t>& activePlayers)
+void Engine::ProcessTournaments(const vector<Tournament>& tournaments)
 {
-	string8_t oveallDir = "./ratings/" + m_name + "/overall";
-	m_overallSeason->DumpActiveRating(oveallDir + "/rating_active.csv", activePlayers);
-	m_overallSeason->DumpHistory(oveallDir + "/rating.csv", oveallDir + "/history.csv", oveallDir + "/players");
+	EXPECT(m_numTournaments <= tournaments.size());
+	size_t begin = m_numTournaments;
 
-	if (m_seasons.size() == 1)
-		return;
+	string8_t rootDir = "./ratings/" + m_name;
+	vector<View> views;
+	views.push_back(View(*m_overallSeason, rootDir + "/overall"));
+	for (uint32_t i = 0; i < m_tags.size(); ++i)
+	{
+		views.push_back(View(m_tagSeasons[i], rootDir + "/tags/" + m_tags[i]));
+	}
+	views.push_back(View(m_seasons.back(), rootDir + "/season" + ToString(m_seasons.size())));
+
+	for (uint32_t i = begin; i < tournaments.size(); ++i)
+	{
+		const Tournament& tournament = tournaments[i];
+		views.front().m_tournaments.push_back(i);
+		for (uint32_t tag = 0; tag < m_tags.size(); ++tag)
+		{
+			if (HasTag(tournament, m_tags[tag]))
+			{
+				views[tag + 1].m_tournaments.push_back(i);
+			}
+		}
+		views.back().m_tournaments.push_back(i);
 
+		if (tournament.m_endOfSeason)
+		{
+			m_seasons.push_back(m_system->NewSeason(m_players).release());
+			views.push_back(View(m_seasons.back(), rootDir + "/season" + ToString(m_seasons.size())));
+		}
+	}
+
+	ParallelFor(views.size(), boost::bind(&PlayTask, boost::ref(views), boost::cref(tournaments), _1));
+	PrintReports(views);
+	m_numTournaments = tournaments.size();
+}
+
+bool Engine::LoadCheckpoint(const string8_t& checkpointFile, const vector<Tournament>& tournaments)
+{
+	using namespace boost::interprocess;
+
+	EXPECT(m_numTournaments == 0);
+	if (!boost::filesystem::exists(checkpointFile) || boost::filesystem::file_size(checkpointFile) == 0)
+		return false;
+
+	try
+	{
+		file_mapping file(checkpointFile.c_str(), read_only);
+		mapped_region region(file, read_only);
+		const char* data = static_cast<const char*>(region.get_address());
+		BinaryReader reader(data, data + region.get_size());
+
+		EXPECT(memcmp(reader.Skip(sizeof(Magic)), Magic, sizeof(Magic)) == 0);
+		EXPECT(reader.Read<uint32_t>() == Version);
+		EXPECT(reader.ReadString() == m_name);
+		uint32_t numTournaments = reader.Read<uint32_t>();
+		EXPECT(numTournaments <= tournaments.size());
+		EXPECT(reader.Read<uint64_t>() == CalculateTournamentsHash(tournaments, numTournaments));
+		EXPECT(reader.Read<uint32_t>() == m_tags.size());
+		BOOST_FOREACH(const string8_t& tag, m_tags)
+		{
+			EXPECT(reader.ReadString() == tag);
+		}
+
+		boost::scoped_ptr<ISeason> overallSeason(m_system->NewSeason(m_players).release());
+		overallSeason->Load(reader);
+		boost::ptr_vector<ISeason> tagSeasons;
+		for (uint32_t i = 0; i < m_tags.size(); ++i)
+		{
+			tagSeasons.push_back(m_system->NewSeason(m_players).release());
+			tagSeasons.back().Load(reader);
+		}
+		uint32_t numSeasons = reader.Read<uint32_t>();
+		EXPECT(numSeasons != 0);
+		boost::ptr_vector<ISeason> seasons;
+		for (uint32_t i = 0; i < numSeasons; ++i)
+		{
+			seasons.push_back(m_system->NewSeason(m_players).release());
+			seasons.back().Load(reader);
+		}
+		EXPECT(reader.IsEnd());
+
+		m_overallSeason.swap(overallSeason);
+		m_tagSeasons.swap(tagSeasons);
+		m_seasons.swap(seasons);
+		m_numTournaments = numTournaments;
+		return true;
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+}
+
+void Engine::SaveCheckpoint(const string8_t& checkpointFile, const vector<Tournament>& tournaments) const
+{
+	EXPECT(m_numTournaments <= tournaments.size());
+
+	string8_t output(Magic, Magic + sizeof(Magic));
+	Append(output, Version);
+	AppendString(output, m_name);
+	Append(output, m_numTournaments);
+	Append(output, CalculateTournamentsHash(tournaments, m_numTournaments));
+	Append(output, uint32_t(m_tags.size()));
+	BOOST_FOREACH(const string8_t& tag, m_tags)
+	{
+		AppendString(output, tag);
+	}
+
+	m_overallSeason->Save(output);
+	BOOST_FOREACH(const ISeason& season, m_tagSeasons)
+	{
+		season.Save(output);
+	}
+	Append(output, uint32_t(m_seasons.size()));
+	BOOST_FOREACH(const ISeason& season, m_seasons)
+	{
+		season.Save(output);
+	}
+	system::SaveToFile(checkpointFile, output);
+}
+
+vector<Rating> Engine::GetOverallRatings() const
+{
+	return m_overallSeason->GetRatings();
+}
+
+void Engine::End(const vector<PlayerId>& activePlayers, uint32_t activeRatingSize, HistoryLayout layout, IOutput& writer)
+{
+	string8_t rootDir = "./ratings/" + m_name;
+	vector<View> outputs;
+	outputs.push_back(View(*m_overallSeason, rootDir + "/overall"));
+	for (uint32_t i = 0; i < m_tags.size(); ++i)
+	{
+		outputs.push_back(View(m_tagSeasons[i], rootDir + "/tags/" + m_tags[i]));
+	}
 	for (uint32_t i = 0; i < m_seasons.size(); ++i)
 	{
-		string8_t seasonDir = "./ratings/" + m_name + "/season" + ToString(i + 1);
-		m_seasons.at(i).DumpHistory(seasonDir + "/rating.csv", seasonDir + "/history.csv", seasonDir + "/players");
+		outputs.push_back(View(m_seasons[i], rootDir + "/season" + ToString(i + 1)));
 	}
+
+	// Seasons played one tournament at a time or restored from a checkpoint are brought up to date before anything is written.
+	ParallelFor(outputs.size(), boost::bind(&UpdateTask, boost::ref(outputs), _1));
+	PrintReports(outputs);
+	if (m_seasons.size() == 1)
+	{
+		outputs.pop_back();
+	}
+
+	m_overallSeason->DumpActiveRating(rootDir + "/overall/rating_active.csv", activePlayers, activeRatingSize, writer);
+	ParallelFor(outputs.size(), boost::bind(&DumpTask, boost::cref(outputs), layout, boost::ref(writer), _1));
 }
 
 } // namespace ratings
@@ -3,26 +3,38 @@
 
 #include "system.h"
 #include "tournament.h"
+#include "players.h"
 #include <boost/scoped_ptr.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 
 namespace my {
 namespace ratings {
 
+// ProcessTournaments() continues after the tournaments already processed, including the ones restored from a checkpoint.
+// A checkpoint is only restored while the tournaments it covers are still the first ones in the list, unchanged.
 class Engine
 {
 public:
-	explicit Engine(const string8_t& name, std::auto_ptr<ISystem>& system);
+	explicit Engine(const string8_t& name, std::auto_ptr<ISystem>& system, const PlayerRegistry& players, const vector<string8_t>& tags);
 
 public:
+	const string8_t& GetName() const;
 	void ProcessTournament(const Tournament& tournament);
-	void End(const vector<string8_t>& activePlayers);
+	void ProcessTournaments(const vector<Tournament>& tournaments);
+	bool LoadCheckpoint(const string8_t& checkpointFile, const vector<Tournament>& tournaments);
+	void SaveCheckpoint(const string8_t& checkpointFile, const vector<Tournament>& tournaments) const;
+	vector<Rating> GetOverallRatings() const;
+	void End(const vector<PlayerId>& activePlayers, uint32_t activeRatingSize, HistoryLayout layout, IOutput& writer);
 
 private:
 	const string8_t m_name;
+	const PlayerRegistry& m_players;
 	boost::scoped_ptr<ISystem> m_system;
 	boost::scoped_ptr<ISeason> m_overallSeason;
 	boost::ptr_vector<ISeason> m_seasons;
+	const vector<string8_t> m_tags;
+	boost::ptr_vector<ISeason> m_tagSeasons;
+	uint32_t m_numTournaments;
 };
 
 } // namespace ratings
@@ -0,0 +1,414 @@
+#include "file_writer.h"
+#include "parallel.h"
+#include "hash.h"
+#include <framework/system/file.h>
+#include <framework/rtl/formatting.h>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const size_t BatchSize = 64;
+const size_t MaxQueuedBytes = 64 << 20;
+const size_t MaxBuffers = 256;
+
+} // namespace
+
+class FileWriter::Stream: public IOutputStream
+{
+public:
+	explicit Stream(FileWriter& writer, uint32_t phase, const string8_t& filePath)
+		: m_writer(writer)
+		, m_phase(phase)
+		, m_filePath(filePath)
+		, m_tempFilePath(filePath + ".tmp")
+		, m_hash(CalculateHash(string8_t()))
+		, m_size(0)
+		, m_microseconds(0)
+		, m_isCompared(false)
+		, m_isClosed(false)
+	{
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		OutputFileInfo savedInfo;
+		if (m_writer.m_manifest.FindSaved(m_filePath, savedInfo) && savedInfo.m_size != 0)
+		{
+			try
+			{
+				using namespace boost::interprocess;
+				m_savedFile.reset(new file_mapping(m_filePath.c_str(), read_only));
+				m_savedRegion.reset(new mapped_region(*m_savedFile, read_only));
+				m_isCompared = true;
+			}
+			catch (std::exception&)
+			{
+				m_savedRegion.reset();
+				m_savedFile.reset();
+			}
+		}
+		if (!m_savedRegion)
+		{
+			OpenTempFile();
+		}
+		m_microseconds += (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+	}
+
+	~Stream()
+	{
+		if (!m_isClosed)
+		{
+			RemoveTempFile();
+		}
+	}
+
+public:
+	void Write(string8_t& text)
+	{
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		if (m_savedRegion && !IsSaved(text))
+		{
+			OpenTempFile();
+		}
+		m_hash = UpdateHash(m_hash, text.data(), text.size());
+		m_size += text.size();
+		if (m_error.empty() && m_file)
+		{
+			try
+			{
+				m_file->Write(text);
+			}
+			catch (std::exception& e)
+			{
+				m_error = m_filePath + ": " + e.what();
+			}
+		}
+		m_microseconds += (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+		text.clear();
+	}
+
+	void Close()
+	{
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		if (m_savedRegion && m_size != m_savedRegion->get_size())
+		{
+			OpenTempFile();
+		}
+		// A compared stream is unchanged only if it never left the previous file.
+		bool isSaved = m_savedRegion.get() != 0;
+		m_savedRegion.reset();
+		m_savedFile.reset();
+
+		m_isClosed = true;
+		OutputFileInfo info;
+		info.m_size = m_size;
+		info.m_hash = m_hash;
+		bool isUnchanged = m_isCompared ? isSaved : m_writer.m_manifest.IsUnchanged(m_filePath, info);
+		bool isWritten = false;
+
+		m_file.reset();
+		if (m_error.empty() && !isUnchanged)
+		{
+			try
+			{
+				boost::filesystem::rename(m_tempFilePath, m_filePath);
+				isWritten = true;
+			}
+			catch (std::exception& e)
+			{
+				m_error = m_filePath + ": " + e.what();
+			}
+		}
+		if (!isWritten)
+		{
+			RemoveTempFile();
+		}
+		m_microseconds += (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+
+		boost::mutex::scoped_lock lock(m_writer.m_mutex);
+		m_writer.AddFile(m_phase, m_filePath, info, isWritten, isUnchanged, m_microseconds);
+		m_writer.Fail(m_error);
+	}
+
+private:
+	bool IsSaved(const string8_t& text) const
+	{
+		return m_size + text.size() <= m_savedRegion->get_size()
+			&& memcmp(static_cast<const char*>(m_savedRegion->get_address()) + m_size, text.data(), text.size()) == 0;
+	}
+
+	// Leaves the previous file, copying the part of it that the stream has matched so far.
+	void OpenTempFile()
+	{
+		try
+		{
+			boost::filesystem::path directory = boost::filesystem::path(m_tempFilePath).parent_path();
+			if (!directory.empty())
+			{
+				boost::filesystem::create_directories(directory);
+			}
+			m_file.reset(new system::File(m_tempFilePath, system::file_access_rights::Write, system::file_creation::CreateAlways));
+			if (m_savedRegion && m_size != 0)
+			{
+				const char* data = static_cast<const char*>(m_savedRegion->get_address());
+				m_file->Write(string8_t(data, data + m_size));
+			}
+		}
+		catch (std::exception& e)
+		{
+			m_error = m_filePath + ": " + e.what();
+		}
+		m_savedRegion.reset();
+		m_savedFile.reset();
+	}
+
+	void RemoveTempFile()
+	{
+		m_file.reset();
+		boost::system::error_code error;
+		boost::filesystem::remove(m_tempFilePath, error);
+	}
+
+private:
+	FileWriter& m_writer;
+	const uint32_t m_phase;
+	const string8_t m_filePath;
+	const string8_t m_tempFilePath;
+	boost::scoped_ptr<system::File> m_file;
+	boost::scoped_ptr<boost::interprocess::file_mapping> m_savedFile;
+	boost::scoped_ptr<boost::interprocess::mapped_region> m_savedRegion;
+	uint64_t m_hash;
+	uint64_t m_size;
+	int64_t m_microseconds;
+	bool m_isCompared;
+	bool m_isClosed;
+	string8_t m_error;
+};
+
+FileWriter::FileWriter(const string8_t& manifestFile, bool removeStaleFiles)
+	: m_manifest(manifestFile)
+	, m_removeStaleFiles(removeStaleFiles)
+	, m_queuedBytes(0)
+	, m_numBusy(0)
+	, m_isStopped(false)
+	, m_failed(false)
+{
+	for (uint32_t i = 0; i < GetNumWorkers(); ++i)
+	{
+		m_threads.create_thread(boost::bind(&FileWriter::Run, this));
+	}
+}
+
+FileWriter::~FileWriter()
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_isStopped = true;
+	}
+	m_hasWork.notify_all();
+	m_threads.join_all();
+}
+
+void FileWriter::Write(const string8_t& phase, const string8_t& filePath, string8_t& text)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	while (m_queuedBytes > MaxQueuedBytes)
+	{
+		m_hasSpace.wait(lock);
+	}
+
+	m_queue.push_back(Item());
+	Item& item = m_queue.back();
+	item.m_phase = GetPhase(phase);
+	item.m_filePath = filePath;
+	item.m_text.swap(text);
+	m_queuedBytes += item.m_text.size();
+	if (!m_buffers.empty())
+	{
+		text.swap(m_buffers.back());
+		m_buffers.pop_back();
+	}
+	m_hasWork.notify_one();
+}
+
+std::auto_ptr<IOutputStream> FileWriter::Open(const string8_t& phase, const string8_t& filePath)
+{
+	uint32_t phaseIndex = 0;
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		phaseIndex = GetPhase(phase);
+	}
+	return std::auto_ptr<IOutputStream>(new Stream(*this, phaseIndex, filePath));
+}
+
+void FileWriter::Flush()
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	while (!m_queue.empty() || m_numBusy != 0)
+	{
+		m_isIdle.wait(lock);
+	}
+
+	if (m_removeStaleFiles)
+	{
+		// Directories left empty go too, up to the first one that still has files.
+		BOOST_FOREACH(const string8_t& filePath, m_manifest.GetStaleFiles())
+		{
+			boost::system::error_code error;
+			boost::filesystem::remove(filePath, error);
+			for (boost::filesystem::path directory = boost::filesystem::path(filePath).parent_path(); !directory.empty() && !error; directory = directory.parent_path())
+			{
+				if (!boost::filesystem::is_empty(directory, error) || error || !boost::filesystem::remove(directory, error))
+					break;
+			}
+		}
+	}
+	m_manifest.Save(!m_removeStaleFiles);
+
+	if (m_failed)
+	{
+		m_failed = false;
+		throw std::runtime_error(m_error);
+	}
+}
+
+string8_t FileWriter::GetReport() const
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	string8_t report;
+	for (size_t i = 0; i < m_phases.size(); ++i)
+	{
+		const PhaseStats& stats = m_phases[i];
+		report += stats.m_name + ": " + ToString(stats.m_numFiles) + " files, " + ToString(stats.m_numWritten) + " written, " + ToString(stats.m_numBytes) + " bytes, " + ToString(stats.m_microseconds/1000000., StandartPrintDigitsAfterDot) + " s\n";
+	}
+	return report;
+}
+
+void FileWriter::Run()
+{
+	vector<Item> batch;
+	for (;;)
+	{
+		{
+			boost::mutex::scoped_lock lock(m_mutex);
+			while (m_queue.empty() && !m_isStopped)
+			{
+				m_hasWork.wait(lock);
+			}
+			if (m_queue.empty())
+				return;
+
+			size_t count = std::min(m_queue.size(), BatchSize);
+			batch.resize(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				Item& item = m_queue.front();
+				batch[i].m_phase = item.m_phase;
+				batch[i].m_filePath.swap(item.m_filePath);
+				batch[i].m_text.swap(item.m_text);
+				m_queuedBytes -= batch[i].m_text.size();
+				m_queue.pop_front();
+			}
+			++m_numBusy;
+		}
+		m_hasSpace.notify_all();
+
+		vector<int64_t> microseconds(batch.size(), 0);
+		vector<OutputFileInfo> infos(batch.size());
+		vector<bool> isWritten(batch.size(), false);
+		vector<bool> isUnchanged(batch.size(), false);
+		string8_t error;
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			infos[i].m_size = batch[i].m_text.size();
+			infos[i].m_hash = CalculateHash(batch[i].m_text);
+			isUnchanged[i] = m_manifest.IsUnchanged(batch[i].m_filePath, infos[i]);
+			if (isUnchanged[i])
+				continue;
+
+			boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+			try
+			{
+				system::SaveToFile(batch[i].m_filePath, batch[i].m_text);
+				isWritten[i] = true;
+			}
+			catch (std::exception& e)
+			{
+				if (error.empty())
+				{
+					error = batch[i].m_filePath + ": " + e.what();
+				}
+			}
+			microseconds[i] = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+		}
+
+		boost::mutex::scoped_lock lock(m_mutex);
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			AddFile(batch[i].m_phase, batch[i].m_filePath, infos[i], isWritten[i], isUnchanged[i], microseconds[i]);
+			if (m_buffers.size() < MaxBuffers)
+			{
+				batch[i].m_text.clear();
+				m_buffers.push_back(string8_t());
+				m_buffers.back().swap(batch[i].m_text);
+			}
+		}
+		Fail(error);
+		if (--m_numBusy == 0 && m_queue.empty())
+		{
+			m_isIdle.notify_all();
+		}
+	}
+}
+
+uint32_t FileWriter::GetPhase(const string8_t& phase)
+{
+	for (uint32_t i = 0; i < m_phases.size(); ++i)
+	{
+		if (m_phases[i].m_name == phase)
+			return i;
+	}
+
+	PhaseStats stats;
+	stats.m_name = phase;
+	stats.m_numFiles = 0;
+	stats.m_numWritten = 0;
+	stats.m_numBytes = 0;
+	stats.m_microseconds = 0;
+	m_phases.push_back(stats);
+	return m_phases.size() - 1;
+}
+
+void FileWriter::AddFile(uint32_t phase, const string8_t& filePath, const OutputFileInfo& info, bool isWritten, bool isUnchanged, int64_t microseconds)
+{
+	if (isWritten || isUnchanged)
+	{
+		m_manifest.Add(filePath, info);
+	}
+
+	PhaseStats& stats = m_phases[phase];
+	++stats.m_numFiles;
+	stats.m_numWritten += isWritten;
+	stats.m_numBytes += info.m_size;
+	stats.m_microseconds += microseconds;
+}
+
+void FileWriter::Fail(const string8_t& error)
+{
+	if (!error.empty() && !m_failed)
+	{
+		m_failed = true;
+		m_error = error;
+	}
+}
+
+} // namespace ratings
+} // namespace my
@@ -0,0 +1,82 @@
+#ifndef _EDDCF208_4FF7_490F_BF32_DC63CBDDF110_
+#define _EDDCF208_4FF7_490F_BF32_DC63CBDDF110_
+
+#include "output.h"
+#include "output_manifest.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
+
+namespace my {
+namespace ratings {
+
+// Saves files on a pool of GetNumWorkers() threads, taking them from the queue in batches.
+// Write() leaves a cleared recycled buffer in place of the text.
+// Files whose content matches the manifest of the previous run are not rewritten.
+// Open() streams to a temporary file in the calling thread and replaces the file on Close(), unless it is unchanged.
+// A stream of a file listed in the manifest is compared with the previous file instead, and the temporary file is only
+// created at the first difference, so an unchanged stream costs a read of the previous file and no writes.
+// Write time is accumulated per phase, the first failure is rethrown by Flush().
+class FileWriter: public IOutput
+{
+public:
+	explicit FileWriter(const string8_t& manifestFile, bool removeStaleFiles);
+	~FileWriter();
+
+public:
+	void Write(const string8_t& phase, const string8_t& filePath, string8_t& text);
+	std::auto_ptr<IOutputStream> Open(const string8_t& phase, const string8_t& filePath);
+	void Flush();
+	string8_t GetReport() const;
+
+private:
+	class Stream;
+
+	struct Item
+	{
+		uint32_t m_phase;
+		string8_t m_filePath;
+		string8_t m_text;
+	};
+
+	struct PhaseStats
+	{
+		string8_t m_name;
+		uint64_t m_numFiles;
+		uint64_t m_numWritten;
+		uint64_t m_numBytes;
+		int64_t m_microseconds;
+	};
+
+private:
+	void Run();
+	uint32_t GetPhase(const string8_t& phase);
+	void AddFile(uint32_t phase, const string8_t& filePath, const OutputFileInfo& info, bool isWritten, bool isUnchanged, int64_t microseconds);
+	void Fail(const string8_t& error);
+
+private:
+	OutputManifest m_manifest;
+	const bool m_removeStaleFiles;
+	mutable boost::mutex m_mutex;
+	boost::condition_variable m_hasWork;
+	boost::condition_variable m_hasSpace;
+	boost::condition_variable m_isIdle;
+	std::deque<Item> m_queue;
+	vector<string8_t> m_buffers;
+	vector<PhaseStats> m_phases;
+	size_t m_queuedBytes;
+	uint32_t m_numBusy;
+	bool m_isStopped;
+	bool m_failed;
+	string8_t m_error;
+	boost::thread_group m_threads;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _EDDCF208_4FF7_490F_BF32_DC63CBDDF110_
@@ -0,0 +1,402 @@
+#include "glicko2.h"
+#include "history.h"
+#include "binary.h"
+#include <framework/rtl/expect.h>
+#include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const double Scale = 173.7178;
+const double Pi = 3.14159265358979323846;
+const double VolatilityTolerance = 0.000001;
+const uint32_t MaxVolatilityIterations = 100;
+const uint32_t NoIndex = -1;
+
+// Ratings are kept on the Glicko-2 scale: mu = (rating - startRating)/Scale, phi = deviation/Scale.
+class PlayerStorage
+{
+public:
+	explicit PlayerStorage(const Glicko2Settings& settings)
+		: m_startPhi(settings.m_startDeviation/Scale)
+		, m_startSigma(settings.m_startVolatility)
+	{
+	}
+
+public:
+	// Deviation grows by the volatility for every period the player has skipped since the last one played.
+	void Get(PlayerId player, uint32_t period, double& mu, double& phi, double& sigma) const
+	{
+		if (player >= m_isRated.size() || !m_isRated[player])
+		{
+			mu = 0;
+			phi = m_startPhi;
+			sigma = m_startSigma;
+			return;
+		}
+
+		double idlePeriods = period - m_lastPeriods[player] - 1;
+		mu = m_mu[player];
+		sigma = m_sigma[player];
+		phi = std::min(sqrt(m_phi[player] * m_phi[player] + idlePeriods * sigma * sigma), m_startPhi);
+	}
+
+	void Set(PlayerId player, uint32_t period, double mu, double phi, double sigma)
+	{
+		if (player >= m_isRated.size())
+		{
+			m_mu.resize(player + 1, 0);
+			m_phi.resize(player + 1, 0);
+			m_sigma.resize(player + 1, 0);
+			m_lastPeriods.resize(player + 1, 0);
+			m_isRated.resize(player + 1, false);
+		}
+		m_mu[player] = mu;
+		m_phi[player] = phi;
+		m_sigma[player] = sigma;
+		m_lastPeriods[player] = period;
+		m_isRated[player] = true;
+	}
+
+	void Save(string8_t& output) const
+	{
+		vector<uint8_t> isRated(m_isRated.begin(), m_isRated.end());
+		AppendVector(output, m_mu);
+		AppendVector(output, m_phi);
+		AppendVector(output, m_sigma);
+		AppendVector(output, m_lastPeriods);
+		AppendVector(output, isRated);
+	}
+
+	void Load(BinaryReader& reader)
+	{
+		vector<uint8_t> isRated;
+		reader.ReadVector(m_mu);
+		reader.ReadVector(m_phi);
+		reader.ReadVector(m_sigma);
+		reader.ReadVector(m_lastPeriods);
+		reader.ReadVector(isRated);
+		EXPECT(m_phi.size() == m_mu.size() && m_sigma.size() == m_mu.size() && m_lastPeriods.size() == m_mu.size() && isRated.size() == m_mu.size());
+		m_isRated.assign(isRated.begin(), isRated.end());
+	}
+
+private:
+	const double m_startPhi;
+	const double m_startSigma;
+	vector<double> m_mu;
+	vector<double> m_phi;
+	vector<double> m_sigma;
+	vector<uint32_t> m_lastPeriods;
+	vector<bool> m_isRated;
+};
+
+class VolatilityFunction
+{
+public:
+	explicit VolatilityFunction(double phi, double sigma, double variance, double delta, double volatilityChange)
+		: m_phiSquare(phi * phi)
+		, m_variance(variance)
+		, m_deltaSquare(delta * delta)
+		, m_a(log(sigma * sigma))
+		, m_tauSquare(volatilityChange * volatilityChange)
+	{
+	}
+
+public:
+	double operator()(double x) const
+	{
+		double ex = exp(x);
+		double denominator = m_phiSquare + m_variance + ex;
+		return ex * (m_deltaSquare - m_phiSquare - m_variance - ex)/(2. * denominator * denominator) - (x - m_a)/m_tauSquare;
+	}
+
+	double GetA() const
+	{
+		return m_a;
+	}
+
+	double GetUpperBound(double volatilityChange) const
+	{
+		if (m_deltaSquare > m_phiSquare + m_variance)
+			return log(m_deltaSquare - m_phiSquare - m_variance);
+
+		uint32_t k = 1;
+		while ((*this)(m_a - k * volatilityChange) < 0)
+		{
+			++k;
+		}
+		return m_a - k * volatilityChange;
+	}
+
+private:
+	const double m_phiSquare;
+	const double m_variance;
+	const double m_deltaSquare;
+	const double m_a;
+	const double m_tauSquare;
+};
+
+// Illinois variant of regula falsi, as in the Glicko-2 description; it usually converges in a handful of iterations.
+double SolveVolatility(double phi, double sigma, double variance, double delta, double volatilityChange)
+{
+	VolatilityFunction f(phi, sigma, variance, delta, volatilityChange);
+	double a = f.GetA();
+	double b = f.GetUpperBound(volatilityChange);
+	double fa = f(a);
+	double fb = f(b);
+	for (uint32_t i = 0; i < MaxVolatilityIterations && fabs(b - a) > VolatilityTolerance; ++i)
+	{
+		double c = a + (a - b) * fa/(fb - fa);
+		double fc = f(c);
+		if (fc * fb <= 0)
+		{
+			a = b;
+			fa = fb;
+		}
+		else
+		{
+			fa /= 2;
+		}
+		b = c;
+		fb = fc;
+	}
+	return exp(a/2);
+}
+
+} // namespace
+
+// Matches are collected as two sides each (side 2*i is player A of match i, side 2*i + 1 is player B),
+// and the rating period is computed in End() over contiguous per-side and per-participant arrays.
+class Glicko2Tournament: public ITournament
+{
+public:
+	explicit Glicko2Tournament(const Glicko2Settings& settings, uint32_t pointsPerMatch, PlayerStorage& players, uint32_t& numPeriods, vector<uint32_t>& localIndices, std::auto_ptr<HistoryStorage::Tournament>& tournamentHistory)
+		: m_settings(settings)
+		, m_pointsPerMatch(pointsPerMatch)
+		, m_players(players)
+		, m_numPeriods(numPeriods)
+		, m_localIndices(localIndices)
+		, m_tournamentHistory(tournamentHistory)
+	{
+	}
+
+public:
+	void AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB)
+	{
+		m_sides.push_back(GetLocalIndex(playerA));
+		m_sides.push_back(GetLocalIndex(playerB));
+		m_scores.push_back(scoreA);
+		m_scores.push_back(scoreB);
+	}
+
+	void End()
+	{
+		uint32_t period = m_numPeriods;
+		uint32_t numParticipants = m_participants.size();
+		vector<double> mu(numParticipants), phi(numParticipants), sigma(numParticipants), g(numParticipants);
+		for (uint32_t i = 0; i < numParticipants; ++i)
+		{
+			m_players.Get(m_participants[i], period, mu[i], phi[i], sigma[i]);
+			g[i] = 1./sqrt(1. + 3. * phi[i] * phi[i]/(Pi * Pi));
+		}
+
+		uint32_t numSides = m_sides.size();
+		vector<double> difference(numSides), opponentG(numSides), score(numSides), weight(numSides);
+		for (uint32_t side = 0; side < numSides; ++side)
+		{
+			uint32_t self = m_sides[side];
+			uint32_t opponent = m_sides[side ^ 1];
+			double totalScore = m_scores[side] + m_scores[side ^ 1];
+			difference[side] = mu[self] - mu[opponent];
+			opponentG[side] = g[opponent];
+			score[side] = m_scores[side]/totalScore;
+			weight[side] = totalScore/m_pointsPerMatch;
+		}
+
+		vector<double> variance(numSides), improvement(numSides);
+		for (uint32_t side = 0; side < numSides; ++side)
+		{
+			double expected = 1./(1. + exp(-opponentG[side] * difference[side]));
+			variance[side] = weight[side] * opponentG[side] * opponentG[side] * expected * (1. - expected);
+			improvement[side] = weight[side] * opponentG[side] * (score[side] - expected);
+		}
+
+		vector<double> inverseVariance(numParticipants, 0), totalImprovement(numParticipants, 0);
+		for (uint32_t side = 0; side < numSides; ++side)
+		{
+			inverseVariance[m_sides[side]] += variance[side];
+			totalImprovement[m_sides[side]] += improvement[side];
+		}
+
+		vector<double> newPhiSquare(numParticipants);
+		vector<Rating> changes(numParticipants);
+		for (uint32_t i = 0; i < numParticipants; ++i)
+		{
+			double v = 1./inverseVariance[i];
+			double newSigma = SolveVolatility(phi[i], sigma[i], v, v * totalImprovement[i], m_settings.m_volatilityChange);
+			newPhiSquare[i] = 1./(1./(phi[i] * phi[i] + newSigma * newSigma) + inverseVariance[i]);
+			double newMu = mu[i] + newPhiSquare[i] * totalImprovement[i];
+			m_players.Set(m_participants[i], period, newMu, sqrt(newPhiSquare[i]), newSigma);
+			changes[i].player = m_participants[i];
+			changes[i].value = ToRating(newMu);
+		}
+
+		for (uint32_t side = 0; side < numSides; side += 2)
+		{
+			uint32_t a = m_sides[side];
+			uint32_t b = m_sides[side + 1];
+			double changeA = Scale * newPhiSquare[a] * improvement[side];
+			double changeB = Scale * newPhiSquare[b] * improvement[side + 1];
+			m_tournamentHistory->AddMatch(m_participants[a], m_participants[b], m_scores[side], m_scores[side + 1], ToRating(mu[a]), ToRating(mu[b]), changeA, changeB);
+		}
+		m_tournamentHistory->End(changes);
+
+		BOOST_FOREACH(PlayerId player, m_participants)
+		{
+			m_localIndices[player] = NoIndex;
+		}
+		++m_numPeriods;
+	}
+
+private:
+	uint32_t GetLocalIndex(PlayerId player)
+	{
+		if (player >= m_localIndices.size())
+		{
+			m_localIndices.resize(player + 1, NoIndex);
+		}
+		if (m_localIndices[player] == NoIndex)
+		{
+			m_localIndices[player] = m_participants.size();
+			m_participants.push_back(player);
+		}
+		return m_localIndices[player];
+	}
+
+	double ToRating(double mu) const
+	{
+		return m_settings.m_startRating + Scale * mu;
+	}
+
+private:
+	const Glicko2Settings& m_settings;
+	const uint32_t m_pointsPerMatch;
+	PlayerStorage& m_players;
+	uint32_t& m_numPeriods;
+	vector<uint32_t>& m_localIndices;
+	boost::scoped_ptr<HistoryStorage::Tournament> m_tournamentHistory;
+	vector<PlayerId> m_participants;
+	vector<uint32_t> m_sides;
+	vector<uint32_t> m_scores;
+};
+
+class Glicko2Season: public ISeason
+{
+public:
+	explicit Glicko2Season(const Glicko2Settings& settings, const PlayerRegistry& players)
+		: m_settings(settings)
+		, m_history(players)
+		, m_players(settings)
+		, m_numPeriods(0)
+	{
+	}
+
+public:
+	std::auto_ptr<ITournament> NewTournament(const string8_t& name, uint32_t pointsPerMatch)
+	{
+		return std::auto_ptr<ITournament>(new Glicko2Tournament(m_settings, pointsPerMatch, m_players, m_numPeriods, m_localIndices, std::auto_ptr<HistoryStorage::Tournament>(new HistoryStorage::Tournament(m_history, name))));
+	}
+
+	string8_t Update()
+	{
+		return string8_t();
+	}
+
+	void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir, HistoryLayout layout, IOutput& writer)
+	{
+		m_history.DumpHistory(ratingFile, ratingHistoryFile, playersDir, layout, writer);
+	}
+
+	vector<Rating> GetRatings() const
+	{
+		return m_history.GetRatings();
+	}
+
+	void DumpActiveRating(const string8_t& ratingFile, const vector<PlayerId>& activePlayers, uint32_t maxCount, IOutput& writer)
+	{
+		m_history.DumpActiveRating(ratingFile, activePlayers, maxCount, writer);
+	}
+
+	void Save(string8_t& output) const
+	{
+		Append(output, m_settings.m_startRating);
+		Append(output, m_settings.m_startDeviation);
+		Append(output, m_settings.m_startVolatility);
+		Append(output, m_settings.m_volatilityChange);
+		m_players.Save(output);
+		Append(output, m_numPeriods);
+		m_history.Save(output);
+	}
+
+	void Load(BinaryReader& reader)
+	{
+		EXPECT(reader.Read<double>() == m_settings.m_startRating);
+		EXPECT(reader.Read<double>() == m_settings.m_startDeviation);
+		EXPECT(reader.Read<double>() == m_settings.m_startVolatility);
+		EXPECT(reader.Read<double>() == m_settings.m_volatilityChange);
+		m_players.Load(reader);
+		m_numPeriods = reader.Read<uint32_t>();
+		m_history.Load(reader);
+	}
+
+private:
+	const Glicko2Settings m_settings;
+	HistoryStorage m_history;
+	PlayerStorage m_players;
+	uint32_t m_numPeriods;
+	vector<uint32_t> m_localIndices;
+};
+
+class Glicko2System: public ISystem
+{
+public:
+	explicit Glicko2System(const Glicko2Settings& settings) : m_settings(settings) { }
+
+public:
+	std::auto_ptr<ISeason> NewSeason(const PlayerRegistry& players)
+	{
+		return std::auto_ptr<ISeason>(new Glicko2Season(m_settings, players));
+	}
+
+private:
+	const Glicko2Settings m_settings;
+};
+
+std::auto_ptr<ISystem> CreateGlicko2System(const Glicko2Settings& settings)
+{
+	return std::auto_ptr<ISystem>(new Glicko2System(settings));
+}
+
+Glicko2Settings::Glicko2Settings(double startRating, double startDeviation, double startVolatility, double volatilityChange)
+	: m_startRating(startRating)
+	, m_startDeviation(startDeviation)
+	, m_startVolatility(startVolatility)
+	, m_volatilityChange(volatilityChange)
+{
+	EXPECT(m_startRating > 0);
+	EXPECT(m_startDeviation > 0);
+	EXPECT(m_startVolatility > 0);
+	EXPECT(m_volatilityChange > 0);
+}
+
+Glicko2Settings StandartGlicko2Settings()
+{
+	return Glicko2Settings(1500, 350, 0.06, 0.5);
+}
+
+} // namespace ratings
+} // namespace my
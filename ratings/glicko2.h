@@ -0,0 +1,27 @@
+#ifndef _84435F0D_0E03_4C1A_A78C_D5AAC6CC52E6_
+#define _84435F0D_0E03_4C1A_A78C_D5AAC6CC52E6_
+
+#include "system.h"
+
+namespace my {
+namespace ratings {
+
+// Every tournament is one rating period.
+struct Glicko2Settings
+{
+	Glicko2Settings(double startRating, double startDeviation, double startVolatility, double volatilityChange);
+
+	double m_startRating;
+	double m_startDeviation;
+	double m_startVolatility;
+	double m_volatilityChange;
+};
+
+Glicko2Settings StandartGlicko2Settings();
+
+std::auto_ptr<ISystem> CreateGlicko2System(const Glicko2Settings& settings);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _84435F0D_0E03_4C1A_A78C_D5AAC6CC52E6_
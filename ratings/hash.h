@@ -0,0 +1,34 @@
+#ifndef _7F685056_7F50_4631_A382_B3EE20E8CCB6_
+#define _7F685056_7F50_4631_A382_B3EE20E8CCB6_
+
+#include <framework/types/string.h>
+#include <framework/types/types.h>
+
+namespace my {
+namespace ratings {
+
+// 64-bit FNV-1a.
+inline uint64_t UpdateHash(uint64_t hash, const char* data, size_t size)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= uint8_t(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+inline uint64_t CalculateHash(const char* data, size_t size)
+{
+	return UpdateHash(14695981039346656037ULL, data, size);
+}
+
+inline uint64_t CalculateHash(const string8_t& text)
+{
+	return CalculateHash(text.data(), text.size());
+}
+
+} // namespace ratings
+} // namespace my
+
+#endif // _7F685056_7F50_4631_A382_B3EE20E8CCB6_
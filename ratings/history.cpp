@@ -1,115 +1,464 @@
 #include "history.h"
-#include <framework/system/file.h>
+#include "output.h"
+#include "binary.h"
+#include "text_format.h"
 #include <framework/rtl/expect.h>
 #include <framework/rtl/formatting.h>
-#include <boost/range/algorithm/find.hpp>
-#include <boost/range/algorithm/find_if.hpp>
-#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <algorithm>
 
 namespace my {
 namespace ratings {
 namespace {
 
-string8_t GetRatingsText(const vector<Rating>& ratings)
+const size_t HistoryBufferSize = 1 << 20;
+const uint32_t HistoryBlockCells = 1 << 22;
+const uint32_t MinHistoryBlockRows = 256;
+const uint32_t NoIndex = -1;
+
+// Order statistics over a set of keys: a Fenwick tree counts the keys present, so a key is added, removed or found by its rank in O(log size).
+class RankIndex
+{
+public:
+	explicit RankIndex(uint32_t size)
+		: m_counts(size + 1, 0)
+		, m_highestStep(1)
+	{
+		while (2 * m_highestStep <= size)
+		{
+			m_highestStep *= 2;
+		}
+	}
+
+public:
+	void Clear()
+	{
+		std::fill(m_counts.begin(), m_counts.end(), 0);
+	}
+
+	void Add(uint32_t key)
+	{
+		for (uint32_t i = key + 1; i < m_counts.size(); i += i & (~i + 1))
+		{
+			++m_counts[i];
+		}
+	}
+
+	void Remove(uint32_t key)
+	{
+		for (uint32_t i = key + 1; i < m_counts.size(); i += i & (~i + 1))
+		{
+			--m_counts[i];
+		}
+	}
+
+	// Returns the key preceded by exactly rank smaller keys.
+	uint32_t Select(uint32_t rank) const
+	{
+		uint32_t position = 0;
+		for (uint32_t step = m_highestStep; step != 0; step /= 2)
+		{
+			if (position + step < m_counts.size() && m_counts[position + step] <= rank)
+			{
+				position += step;
+				rank -= m_counts[position];
+			}
+		}
+		return position;
+	}
+
+private:
+	vector<uint32_t> m_counts;
+	uint32_t m_highestStep;
+};
+
+// The leaderboard order of rating changes: higher ratings first, ties in the order the players were first rated.
+class ChangeLess
+{
+public:
+	explicit ChangeLess(const vector<PlayerId>& players, const vector<double>& ratings, const vector<uint32_t>& orders)
+		: m_players(players)
+		, m_ratings(ratings)
+		, m_orders(orders)
+	{
+	}
+
+public:
+	bool operator()(uint32_t left, uint32_t right) const
+	{
+		if (m_ratings[left] != m_ratings[right])
+			return m_ratings[left] > m_ratings[right];
+		if (m_players[left] != m_players[right])
+			return m_orders[m_players[left]] < m_orders[m_players[right]];
+		return left < right;
+	}
+
+private:
+	const vector<PlayerId>& m_players;
+	const vector<double>& m_ratings;
+	const vector<uint32_t>& m_orders;
+};
+
+string8_t GetRatingsText(const vector<Rating>& ratings, const PlayerRegistry& players)
 {
 	string8_t text;
 	for (size_t i = 0; i < ratings.size(); ++i)
 	{
 		const Rating& rating = ratings[i];
-		text += ToString(i+1) + ", " + rating.player + ", " + ToString(rating.value, StandartPrintDigitsAfterDot) + "\n";
+		AppendInteger(text, i + 1);
+		text += ", ";
+		text += players.GetName(rating.player);
+		text += ", ";
+		AppendFixed(text, rating.value, StandartPrintDigitsAfterDot);
+		text += '\n';
 	}
 	return text;
 }
 
+void AppendRatingChange(string8_t& text, double prevRating, double changeInRating)
+{
+	text += '(';
+	AppendFixed(text, prevRating, StandartPrintDigitsAfterDot);
+	text += (changeInRating > 0 ? " +" : " ");
+	AppendFixed(text, changeInRating, StandartPrintDigitsAfterDot);
+	text += ')';
+}
+
+void AppendMatchSide(string8_t& text, double rating, double change, const string8_t& name, uint32_t score)
+{
+	AppendRatingChange(text, rating, change);
+	text += ", ";
+	text += name;
+	text += ", (";
+	AppendInteger(text, score);
+	text += ')';
+}
+
+void AppendOpponentSide(string8_t& text, double rating, double change, const string8_t& name, uint32_t score)
+{
+	text += '(';
+	AppendInteger(text, score);
+	text += "), ";
+	text += name;
+	text += ", ";
+	AppendRatingChange(text, rating, change);
+}
+
 } // namespace 
 
 HistoryStorage::Tournament::Tournament(HistoryStorage& storage, const string8_t& name)
 	: m_storage(storage)
 	, m_name(name)
+	, m_index(storage.m_tournaments.size())
 {
 }
 
-void HistoryStorage::Tournament::AddRecord(const string8_t& player, const string8_t& text)
+void HistoryStorage::Tournament::AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB, double ratingA, double ratingB, double changeA, double changeB)
 {
-	AddPlayerHistory(player, text, m_playerHistory);
+	MatchRecord record;
+	record.tournament = m_index;
+	record.playerA = playerA;
+	record.playerB = playerB;
+	record.scoreA = scoreA;
+	record.scoreB = scoreB;
+	record.ratingA = ratingA;
+	record.ratingB = ratingB;
+	record.changeA = changeA;
+	record.changeB = changeB;
+	m_storage.m_matches.push_back(record);
 }
 
-void HistoryStorage::Tournament::End(const vector<Rating>& ratings)
+void HistoryStorage::Tournament::End(const vector<Rating>& changedRatings)
 {
-	m_storage.m_tournamentNames += ", " + m_name;
-	m_storage.m_ratingsHistory.push_back(ratings);
-	BOOST_FOREACH(const PlayerHistory& item, m_playerHistory)
+	EXPECT(m_index == m_storage.m_tournaments.size());
+	m_storage.m_tournaments.push_back(m_name);
+	BOOST_FOREACH(const Rating& rating, changedRatings)
 	{
-		AddPlayerHistory(item.player, m_name + ",,,,\n" + item.text, m_storage.m_playersHistory);
+		m_storage.m_changedPlayers.push_back(rating.player);
+		m_storage.m_changedRatings.push_back(rating.value);
+		m_storage.m_leaderboard.Set(rating.player, rating.value);
 	}
+	m_storage.m_changesEnd.push_back(m_storage.m_changedPlayers.size());
 }
 
 
-void HistoryStorage::DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir)
+HistoryStorage::HistoryStorage(const PlayerRegistry& players)
+	: m_players(players)
+{
+}
+
+void HistoryStorage::DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir, HistoryLayout layout, IOutput& writer)
 {
-	if (m_ratingsHistory.empty())
+	if (m_tournaments.empty())
 		return;
 
-	system::SaveToFile(ratingFile, GetRatingsText(m_ratingsHistory.back()));
+	string8_t ratingText = GetRatingsText(m_leaderboard.GetRatings(), m_players);
+	writer.Write("rating", ratingFile, ratingText);
 
-	uint32_t numTournaments = m_ratingsHistory.size();
-	uint32_t numPlayers = m_ratingsHistory.back().size();
-	string8_t ratingHistoryText = m_tournamentNames + ",\r\n";
-	for (size_t row = 0; row < numPlayers; ++row)
+	// Every rating change gets a fixed key by its place in the ranking order: by value, ties by the order players were first rated in.
+	uint32_t numTournaments = m_tournaments.size();
+	uint32_t numChanges = m_changedPlayers.size();
+	vector<uint32_t> orders(m_players.GetCount(), NoIndex);
+	vector<uint32_t> numRanks(numTournaments);
+	uint32_t numRated = 0;
+	for (uint32_t tournament = 0, i = 0; tournament < numTournaments; ++tournament)
 	{
-		string8_t rowText = ToString(row + 1);
-		for (size_t column = 0; column < numTournaments; ++column)
+		for (; i < m_changesEnd[tournament]; ++i)
 		{
-			rowText += ", ";
-			if (row < m_ratingsHistory[column].size())
+			if (orders[m_changedPlayers[i]] == NoIndex)
 			{
-				const Rating& rating = m_ratingsHistory[column][row];
-				rowText += rating.player + ":" + ToString(rating.value, StandartPrintDigitsAfterDot);
+				orders[m_changedPlayers[i]] = numRated++;
 			}
 		}
-		ratingHistoryText += rowText +  "," + ToString(row + 1) + "\r\n";
+		numRanks[tournament] = numRated;
+	}
+	vector<uint32_t> keyChanges(numChanges);
+	for (uint32_t i = 0; i < numChanges; ++i)
+	{
+		keyChanges[i] = i;
+	}
+	std::sort(keyChanges.begin(), keyChanges.end(), ChangeLess(m_changedPlayers, m_changedRatings, orders));
+	vector<uint32_t> changeKeys(numChanges);
+	for (uint32_t key = 0; key < numChanges; ++key)
+	{
+		changeKeys[keyChanges[key]] = key;
 	}
-	system::SaveToFile(ratingHistoryFile, ratingHistoryText);
 
-	BOOST_FOREACH(const PlayerHistory& item, m_playersHistory)
+	std::auto_ptr<IOutputStream> stream = writer.Open("history", ratingHistoryFile);
+	string8_t ratingHistoryText;
+	ratingHistoryText.reserve(HistoryBufferSize);
+	if (layout == SparseHistory)
 	{
-		system::SaveToFile(playersDir + "/" + item.player + ".csv", "(ratingA +/- deltaA), nameA, (scoreA) - (scoreB), nameB, (ratingB +/- deltaB)\n" + item.text);
+		ratingHistoryText += ", first";
+	}
+	BOOST_FOREACH(const string8_t& tournament, m_tournaments)
+	{
+		ratingHistoryText += ", " + tournament;
+	}
+	ratingHistoryText += ",\r\n";
+
+	// Rows are built block by block: the leaderboards are replayed for every block, and each column keeps only the slice of ranks in the block.
+	uint32_t blockSize = std::max(HistoryBlockCells/numTournaments, MinHistoryBlockRows);
+	vector<uint32_t> cells;
+	vector<uint32_t> playerKeys;
+	RankIndex ranks(numChanges);
+	uint32_t firstColumn = 0;
+	for (uint32_t blockBegin = 0; blockBegin < numRated; blockBegin += blockSize)
+	{
+		uint32_t blockEnd = std::min(blockBegin + blockSize, numRated);
+		cells.assign((blockEnd - blockBegin) * numTournaments, NoIndex);
+		playerKeys.assign(m_players.GetCount(), NoIndex);
+		ranks.Clear();
+		for (uint32_t column = 0; column < numTournaments; ++column)
+		{
+			for (uint32_t i = (column == 0 ? 0 : m_changesEnd[column - 1]); i < m_changesEnd[column]; ++i)
+			{
+				uint32_t& key = playerKeys[m_changedPlayers[i]];
+				if (key != NoIndex)
+				{
+					ranks.Remove(key);
+				}
+				key = changeKeys[i];
+				ranks.Add(key);
+			}
+			for (uint32_t row = blockBegin; row < std::min(blockEnd, numRanks[column]); ++row)
+			{
+				cells[(row - blockBegin) * numTournaments + column] = keyChanges[ranks.Select(row)];
+			}
+		}
+
+		// Leaderboards only grow, so the tournaments before the first one holding a rank are the only empty cells of its row.
+		for (uint32_t row = blockBegin; row < blockEnd; ++row)
+		{
+			while (numRanks[firstColumn] <= row)
+			{
+				++firstColumn;
+			}
+
+			AppendInteger(ratingHistoryText, row + 1);
+			if (layout == SparseHistory)
+			{
+				ratingHistoryText += ", ";
+				AppendInteger(ratingHistoryText, firstColumn + 1);
+			}
+			else
+			{
+				for (size_t column = 0; column < firstColumn; ++column)
+				{
+					ratingHistoryText += ", ";
+				}
+			}
+			for (size_t column = firstColumn; column < numTournaments; ++column)
+			{
+				uint32_t change = cells[(row - blockBegin) * numTournaments + column];
+				ratingHistoryText += ", ";
+				ratingHistoryText += m_players.GetName(m_changedPlayers[change]);
+				ratingHistoryText += ':';
+				AppendFixed(ratingHistoryText, m_changedRatings[change], StandartPrintDigitsAfterDot);
+			}
+			ratingHistoryText += ',';
+			AppendInteger(ratingHistoryText, row + 1);
+			ratingHistoryText += "\r\n";
+
+			if (ratingHistoryText.size() >= HistoryBufferSize)
+			{
+				stream->Write(ratingHistoryText);
+			}
+		}
 	}
+	stream->Write(ratingHistoryText);
+	stream->Close();
+
+	DumpPlayersHistory(playersDir, writer);
 }
 
-void HistoryStorage::DumpActiveRating(const string8_t& ratingFile, const vector<string8_t>& activePlayers)
+void HistoryStorage::DumpActiveRating(const string8_t& ratingFile, const vector<PlayerId>& activePlayers, uint32_t maxCount, IOutput& writer)
 {
-	if (m_ratingsHistory.empty())
+	if (m_tournaments.empty())
 		return;
 
-	vector<Rating> activeRating;
-	BOOST_FOREACH(const Rating& rating, m_ratingsHistory.back())
+	vector<bool> isActive(m_players.GetCount(), false);
+	BOOST_FOREACH(PlayerId player, activePlayers)
 	{
-		if (boost::find(activePlayers, rating.player) != activePlayers.end())
-		{
-			activeRating.push_back(rating);
-		}
+		isActive.at(player) = true;
 	}
-	system::SaveToFile(ratingFile, GetRatingsText(activeRating));
+	string8_t ratingText = GetRatingsText(m_leaderboard.GetTop(maxCount, isActive), m_players);
+	writer.Write("rating", ratingFile, ratingText);
+}
+
+vector<Rating> HistoryStorage::GetRatings() const
+{
+	return m_leaderboard.GetRatings();
 }
 
-void HistoryStorage::AddPlayerHistory(const string8_t& player, const string8_t& text, vector<HistoryStorage::PlayerHistory>& history)
+void HistoryStorage::Save(string8_t& output) const
 {
-	vector<PlayerHistory>::iterator it = boost::find_if(history, boost::bind(&PlayerHistory::player, _1) == player);
-	if (it != history.end())
+	Append(output, uint32_t(m_tournaments.size()));
+	BOOST_FOREACH(const string8_t& tournament, m_tournaments)
 	{
-		it->text += "\n" + text;
+		AppendString(output, tournament);
 	}
-	else
+
+	Append(output, uint32_t(m_matches.size()));
+	BOOST_FOREACH(const MatchRecord& record, m_matches)
 	{
-		PlayerHistory playerHistory(player);
-		playerHistory.text += text;
-		history.push_back(playerHistory);
+		Append(output, record.tournament);
+		Append(output, record.playerA);
+		Append(output, record.playerB);
+		Append(output, record.scoreA);
+		Append(output, record.scoreB);
+		Append(output, record.ratingA);
+		Append(output, record.ratingB);
+		Append(output, record.changeA);
+		Append(output, record.changeB);
 	}
+
+	AppendVector(output, m_changesEnd);
+	AppendVector(output, m_changedPlayers);
+	AppendVector(output, m_changedRatings);
 }
 
-} // namespace ratings
-} // namespace my
+void HistoryStorage::Load(BinaryReader& reader)
+{
+	uint32_t numTournaments = reader.Read<uint32_t>();
+	m_tournaments.resize(numTournaments);
+	for (uint32_t i = 0; i < numTournaments; ++i)
+	{
+		m_tournaments[i] = reader.ReadString();
+	}
 
+	uint32_t numMatches = reader.Read<uint32_t>();
+	m_matches.resize(numMatches);
+	BOOST_FOREACH(MatchRecord& record, m_matches)
+	{
+		record.tournament = reader.Read<uint32_t>();
+		record.playerA = reader.Read<PlayerId>();
+		record.playerB = reader.Read<PlayerId>();
+		record.scoreA = reader.Read<uint32_t>();
+		record.scoreB = reader.Read<uint32_t>();
+		record.ratingA = reader.Read<double>();
+		record.ratingB = reader.Read<double>();
+		record.changeA = reader.Read<double>();
+		record.changeB = reader.Read<double>();
+		EXPECT(record.tournament < numTournaments && record.playerA < m_players.GetCount() && record.playerB < m_players.GetCount());
+	}
 
+	reader.ReadVector(m_changesEnd);
+	reader.ReadVector(m_changedPlayers);
+	reader.ReadVector(m_changedRatings);
+	EXPECT(m_changesEnd.size() == numTournaments && m_changedPlayers.size() == m_changedRatings.size());
+	EXPECT(m_changesEnd.empty() || m_changesEnd.back() == m_changedPlayers.size());
+	BOOST_FOREACH(PlayerId player, m_changedPlayers)
+	{
+		EXPECT(player < m_players.GetCount());
+	}
+
+	m_leaderboard = Leaderboard();
+	for (uint32_t tournament = 0; tournament < numTournaments; ++tournament)
+	{
+		ApplyChanges(tournament, m_leaderboard);
+	}
+}
+
+void HistoryStorage::ApplyChanges(uint32_t tournament, Leaderboard& leaderboard) const
+{
+	uint32_t begin = (tournament == 0 ? 0 : m_changesEnd[tournament - 1]);
+	for (uint32_t i = begin; i < m_changesEnd[tournament]; ++i)
+	{
+		leaderboard.Set(m_changedPlayers[i], m_changedRatings[i]);
+	}
+}
+
+void HistoryStorage::DumpPlayersHistory(const string8_t& playersDir, IOutput& writer)
+{
+	vector<vector<uint32_t> > playerMatches(m_players.GetCount());
+	for (uint32_t i = 0; i < m_matches.size(); ++i)
+	{
+		playerMatches[m_matches[i].playerA].push_back(2 * i);
+		playerMatches[m_matches[i].playerB].push_back(2 * i + 1);
+	}
+
+	string8_t text;
+	for (PlayerId player = 0; player < playerMatches.size(); ++player)
+	{
+		if (playerMatches[player].empty())
+			continue;
+
+		text = "(ratingA +/- deltaA), nameA, (scoreA) - (scoreB), nameB, (ratingB +/- deltaB)\n";
+		uint32_t tournament = m_tournaments.size();
+		BOOST_FOREACH(uint32_t side, playerMatches[player])
+		{
+			const MatchRecord& record = m_matches[side / 2];
+			if (record.tournament != tournament)
+			{
+				if (tournament != m_tournaments.size())
+				{
+					text += "\n";
+				}
+				tournament = record.tournament;
+				text += m_tournaments.at(tournament) + ",,,,";
+			}
+
+			bool isFirst = (side % 2 == 0);
+			const string8_t& nameA = m_players.GetName(record.playerA);
+			const string8_t& nameB = m_players.GetName(record.playerB);
+			text += '\n';
+			if (isFirst)
+			{
+				AppendMatchSide(text, record.ratingA, record.changeA, nameA, record.scoreA);
+				text += " - ";
+				AppendOpponentSide(text, record.ratingB, record.changeB, nameB, record.scoreB);
+			}
+			else
+			{
+				AppendMatchSide(text, record.ratingB, record.changeB, nameB, record.scoreB);
+				text += " - ";
+				AppendOpponentSide(text, record.ratingA, record.changeA, nameA, record.scoreA);
+			}
+		}
+		writer.Write("players", playersDir + "/" + m_players.GetName(player) + ".csv", text);
+	}
+}
+
+} // namespace ratings
+} // namespace my
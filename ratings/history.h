@@ -2,21 +2,32 @@
 #define _0256A281_BA44_4084_8456_86F59B8A38BF_
 
 #include "basic.h"
+#include "players.h"
+#include "leaderboard.h"
+#include <ratings.h>
 #include <framework/types/string.h>
 #include <framework/types/vector.h>
 
 namespace my {
 namespace ratings {
 
+struct IOutput;
+class BinaryReader;
+
 class HistoryStorage
 {
 private:
-	struct PlayerHistory
+	struct MatchRecord
 	{
-		explicit PlayerHistory(const string8_t& player_) : player(player_) { }
-
-		string8_t player;
-		string8_t text;
+		uint32_t tournament;
+		PlayerId playerA;
+		PlayerId playerB;
+		uint32_t scoreA;
+		uint32_t scoreB;
+		double ratingA;
+		double ratingB;
+		double changeA;
+		double changeB;
 	};
 
 public:
@@ -26,27 +37,37 @@ public:
 		explicit Tournament(HistoryStorage& storage, const string8_t& name);
 
 	public:
-		void AddRecord(const string8_t& player, const string8_t& text);
-		void End(const vector<Rating>& ratings);
+		void AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB, double ratingA, double ratingB, double changeA, double changeB);
+		void End(const vector<Rating>& changedRatings);
 
 	private:
 		HistoryStorage& m_storage;
 		const string8_t m_name;
-		vector<PlayerHistory> m_playerHistory;
+		const uint32_t m_index;
 	};
 
 public:
-	void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir);
-	void DumpActiveRating(const string8_t& ratingFile, const vector<string8_t>& activePlayers);
+	explicit HistoryStorage(const PlayerRegistry& players);
+
+public:
+	void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir, HistoryLayout layout, IOutput& writer);
+	void DumpActiveRating(const string8_t& ratingFile, const vector<PlayerId>& activePlayers, uint32_t maxCount, IOutput& writer);
+	vector<Rating> GetRatings() const;
+	void Save(string8_t& output) const;
+	void Load(BinaryReader& reader);
 
 private:
-	static
-	void AddPlayerHistory(const string8_t& player, const string8_t& text, vector<HistoryStorage::PlayerHistory>& history);
+	void DumpPlayersHistory(const string8_t& playersDir, IOutput& writer);
+	void ApplyChanges(uint32_t tournament, Leaderboard& leaderboard) const;
 
 private:
-	vector<vector<Rating> > m_ratingsHistory;
-	vector<PlayerHistory> m_playersHistory;
-	string8_t m_tournamentNames;
+	const PlayerRegistry& m_players;
+	vector<uint32_t> m_changesEnd;
+	vector<PlayerId> m_changedPlayers;
+	vector<double> m_changedRatings;
+	vector<MatchRecord> m_matches;
+	vector<string8_t> m_tournaments;
+	Leaderboard m_leaderboard; // Current standings, updated with the changes of every tournament.
 };
 
 } // namespace ratings
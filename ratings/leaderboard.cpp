@@ -0,0 +1,67 @@
+#include "leaderboard.h"
+
+namespace my {
+namespace ratings {
+namespace {
+
+const uint32_t InvalidOrder = -1;
+
+} // namespace 
+
+void Leaderboard::Set(PlayerId player, double rating)
+{
+	if (player >= m_ratings.size())
+	{
+		m_ratings.resize(player + 1, 0);
+		m_orders.resize(player + 1, InvalidOrder);
+	}
+
+	Entry entry;
+	entry.value = m_ratings[player];
+	entry.order = m_orders[player];
+	entry.player = player;
+	if (entry.order == InvalidOrder)
+	{
+		entry.order = m_orders[player] = m_entries.size();
+	}
+	else
+	{
+		m_entries.erase(entry);
+	}
+
+	entry.value = m_ratings[player] = rating;
+	m_entries.insert(entry);
+}
+
+vector<Rating> Leaderboard::GetRatings() const
+{
+	vector<Rating> result;
+	result.reserve(m_entries.size());
+	for (std::set<Entry, EntryLess>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		Rating rating;
+		rating.player = it->player;
+		rating.value = it->value;
+		result.push_back(rating);
+	}
+	return result;
+}
+
+vector<Rating> Leaderboard::GetTop(uint32_t count, const vector<bool>& isIncluded) const
+{
+	vector<Rating> result;
+	for (std::set<Entry, EntryLess>::const_iterator it = m_entries.begin(); it != m_entries.end() && result.size() < count; ++it)
+	{
+		if (!isIncluded.at(it->player))
+			continue;
+
+		Rating rating;
+		rating.player = it->player;
+		rating.value = it->value;
+		result.push_back(rating);
+	}
+	return result;
+}
+
+} // namespace ratings
+} // namespace my
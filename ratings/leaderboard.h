@@ -0,0 +1,47 @@
+#ifndef _52AD40B5_E76A_448B_8A37_5F43D2E3F215_
+#define _52AD40B5_E76A_448B_8A37_5F43D2E3F215_
+
+#include "basic.h"
+#include <framework/types/vector.h>
+#include <set>
+
+namespace my {
+namespace ratings {
+
+class Leaderboard
+{
+public:
+	void Set(PlayerId player, double rating);
+
+public:
+	vector<Rating> GetRatings() const;
+	vector<Rating> GetTop(uint32_t count, const vector<bool>& isIncluded) const;
+
+private:
+	struct Entry
+	{
+		double value;
+		uint32_t order;
+		PlayerId player;
+	};
+
+	struct EntryLess
+	{
+		bool operator()(const Entry& left, const Entry& right) const
+		{
+			if (left.value != right.value)
+				return left.value > right.value;
+			return left.order < right.order;
+		}
+	};
+
+private:
+	std::set<Entry, EntryLess> m_entries;
+	vector<double> m_ratings;
+	vector<uint32_t> m_orders;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _52AD40B5_E76A_448B_8A37_5F43D2E3F215_
@@ -0,0 +1,52 @@
+#include "match_dataset.h"
+#include "tournament.h"
+#include "tournament_cache.h"
+#include <framework/system/filesystem.h>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+
+namespace my {
+namespace ratings {
+
+MatchDataset::MatchDataset()
+	: m_numPlayers(0)
+{
+}
+
+uint32_t MatchDataset::GetNumMatches() const
+{
+	return m_scores.size();
+}
+
+MatchDataset ReadMatchDataset(const string8_t& logDir, PlayerRegistry& players)
+{
+	vector<Tournament> tournaments = ReadTournaments(system::ListFiles(logDir), logDir + ".cache");
+	std::stable_sort(tournaments.begin(), tournaments.end(), boost::bind(&Tournament::m_date, _1) < boost::bind(&Tournament::m_date, _2));
+
+	MatchDataset dataset;
+	BOOST_FOREACH(Tournament& tournament, tournaments)
+	{
+		players.Register(tournament);
+		AddTournament(dataset, tournament, players);
+	}
+	return dataset;
+}
+
+void AddTournament(MatchDataset& dataset, const Tournament& tournament, const PlayerRegistry& players)
+{
+	for (uint32_t match = 0; match < tournament.GetNumMatches(); ++match)
+	{
+		double scoreA = tournament.m_matchScores[2 * match];
+		double scoreB = tournament.m_matchScores[2 * match + 1];
+		dataset.m_players.push_back(tournament.m_playerIds[tournament.m_matchPlayers[2 * match]]);
+		dataset.m_players.push_back(tournament.m_playerIds[tournament.m_matchPlayers[2 * match + 1]]);
+		dataset.m_scores.push_back(scoreA/(scoreA + scoreB));
+		dataset.m_weights.push_back((scoreA + scoreB)/tournament.m_pointsPerMatch);
+	}
+	dataset.m_tournamentsEnd.push_back(dataset.m_scores.size());
+	dataset.m_numPlayers = players.GetCount();
+}
+
+} // namespace ratings
+} // namespace my
@@ -0,0 +1,37 @@
+#ifndef _DB66021D_1B0A_4254_B305_E9BBEC8D720C_
+#define _DB66021D_1B0A_4254_B305_E9BBEC8D720C_
+
+#include "basic.h"
+#include "players.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+
+namespace my {
+namespace ratings {
+
+struct Tournament;
+
+// Matches of all logs in rating order, without strings, for code that replays them many times.
+// Match i is played by m_players[2*i] and m_players[2*i + 1]; m_scores holds the score share of the first one,
+// m_weights the points played over the points per match. Tournament t holds matches m_tournamentsEnd[t - 1] to m_tournamentsEnd[t].
+struct MatchDataset
+{
+	MatchDataset();
+
+	uint32_t GetNumMatches() const;
+
+	uint32_t m_numPlayers;
+	vector<uint32_t> m_tournamentsEnd;
+	vector<PlayerId> m_players;
+	vector<double> m_scores;
+	vector<double> m_weights;
+};
+
+// Appends the matches of a tournament whose players are already registered.
+void AddTournament(MatchDataset& dataset, const Tournament& tournament, const PlayerRegistry& players);
+MatchDataset ReadMatchDataset(const string8_t& logDir, PlayerRegistry& players);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _DB66021D_1B0A_4254_B305_E9BBEC8D720C_
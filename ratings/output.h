@@ -0,0 +1,35 @@
+#ifndef _01A39A4B_070F_4C01_A133_7BE7CBF5A41E_
+#define _01A39A4B_070F_4C01_A133_7BE7CBF5A41E_
+
+#include <framework/types/string.h>
+#include <memory>
+
+namespace my {
+namespace ratings {
+
+// A file written part by part. Close() completes it, a stream destroyed before Close() leaves no file.
+struct IOutputStream
+{
+	// Takes the text over and leaves an empty buffer in its place.
+	virtual void Write(string8_t& text) = 0;
+	virtual void Close() = 0;
+
+	virtual ~IOutputStream() { }
+};
+
+struct IOutput
+{
+	// Takes the text over and leaves an empty buffer in its place. Safe to call from several threads.
+	virtual void Write(const string8_t& phase, const string8_t& filePath, string8_t& text) = 0;
+	// Safe to call from several threads, every stream is used by one.
+	virtual std::auto_ptr<IOutputStream> Open(const string8_t& phase, const string8_t& filePath) = 0;
+	virtual void Flush() = 0;
+	virtual string8_t GetReport() const = 0;
+
+	virtual ~IOutput() { }
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _01A39A4B_070F_4C01_A133_7BE7CBF5A41E_
@@ -0,0 +1,125 @@
+#include "output_manifest.h"
+#include "binary.h"
+#include <framework/system/file.h>
+#include <framework/rtl/expect.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const char Magic[] = "LCGOUTM";
+const uint32_t Version = 1;
+
+typedef boost::unordered_map<string8_t, OutputFileInfo> FileMap;
+
+} // namespace
+
+OutputManifest::OutputManifest(const string8_t& manifestFile)
+	: m_manifestFile(manifestFile)
+{
+	try
+	{
+		Load();
+	}
+	catch (std::exception&)
+	{
+		m_savedFiles.clear();
+	}
+}
+
+bool OutputManifest::IsUnchanged(const string8_t& filePath, const OutputFileInfo& info) const
+{
+	FileMap::const_iterator it = m_savedFiles.find(filePath);
+	if (it == m_savedFiles.end() || it->second.m_size != info.m_size || it->second.m_hash != info.m_hash)
+		return false;
+
+	boost::system::error_code error;
+	uint64_t size = boost::filesystem::file_size(filePath, error);
+	return !error && size == info.m_size;
+}
+
+bool OutputManifest::FindSaved(const string8_t& filePath, OutputFileInfo& info) const
+{
+	FileMap::const_iterator it = m_savedFiles.find(filePath);
+	if (it == m_savedFiles.end())
+		return false;
+
+	boost::system::error_code error;
+	uint64_t size = boost::filesystem::file_size(filePath, error);
+	if (error || size != it->second.m_size)
+		return false;
+
+	info = it->second;
+	return true;
+}
+
+void OutputManifest::Add(const string8_t& filePath, const OutputFileInfo& info)
+{
+	m_files[filePath] = info;
+}
+
+vector<string8_t> OutputManifest::GetStaleFiles() const
+{
+	vector<string8_t> staleFiles;
+	for (FileMap::const_iterator it = m_savedFiles.begin(); it != m_savedFiles.end(); ++it)
+	{
+		if (m_files.find(it->first) == m_files.end())
+		{
+			staleFiles.push_back(it->first);
+		}
+	}
+	return staleFiles;
+}
+
+void OutputManifest::Save(bool keepStaleFiles) const
+{
+	FileMap files = m_files;
+	if (keepStaleFiles)
+	{
+		files.insert(m_savedFiles.begin(), m_savedFiles.end());
+	}
+
+	string8_t output(Magic, Magic + sizeof(Magic));
+	Append(output, Version);
+	Append(output, uint32_t(files.size()));
+	for (FileMap::const_iterator it = files.begin(); it != files.end(); ++it)
+	{
+		AppendString(output, it->first);
+		Append(output, it->second.m_size);
+		Append(output, it->second.m_hash);
+	}
+	system::SaveToFile(m_manifestFile, output);
+}
+
+void OutputManifest::Load()
+{
+	using namespace boost::interprocess;
+
+	if (!boost::filesystem::exists(m_manifestFile) || boost::filesystem::file_size(m_manifestFile) == 0)
+		return;
+
+	file_mapping file(m_manifestFile.c_str(), read_only);
+	mapped_region region(file, read_only);
+	const char* data = static_cast<const char*>(region.get_address());
+	BinaryReader reader(data, data + region.get_size());
+
+	EXPECT(memcmp(reader.Skip(sizeof(Magic)), Magic, sizeof(Magic)) == 0);
+	EXPECT(reader.Read<uint32_t>() == Version);
+	uint32_t numFiles = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < numFiles; ++i)
+	{
+		string8_t filePath = reader.ReadString();
+		OutputFileInfo info;
+		info.m_size = reader.Read<uint64_t>();
+		info.m_hash = reader.Read<uint64_t>();
+		m_savedFiles[filePath] = info;
+	}
+	EXPECT(reader.IsEnd());
+}
+
+} // namespace ratings
+} // namespace my
@@ -0,0 +1,45 @@
+#ifndef _D0AE2233_58BE_48F8_BBEF_1E8F6F7AC575_
+#define _D0AE2233_58BE_48F8_BBEF_1E8F6F7AC575_
+
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+#include <boost/unordered_map.hpp>
+
+namespace my {
+namespace ratings {
+
+struct OutputFileInfo
+{
+	uint64_t m_size;
+	uint64_t m_hash;
+};
+
+// Sizes and content hashes of the files written by the previous run.
+// A file is unchanged while it still exists with the recorded size and the new text has the recorded hash.
+class OutputManifest
+{
+public:
+	explicit OutputManifest(const string8_t& manifestFile);
+
+public:
+	bool IsUnchanged(const string8_t& filePath, const OutputFileInfo& info) const;
+	// The entry of the previous run, if the file still exists with the recorded size.
+	bool FindSaved(const string8_t& filePath, OutputFileInfo& info) const;
+	void Add(const string8_t& filePath, const OutputFileInfo& info);
+	vector<string8_t> GetStaleFiles() const;
+	void Save(bool keepStaleFiles) const;
+
+private:
+	void Load();
+
+private:
+	const string8_t m_manifestFile;
+	boost::unordered_map<string8_t, OutputFileInfo> m_savedFiles;
+	boost::unordered_map<string8_t, OutputFileInfo> m_files;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _D0AE2233_58BE_48F8_BBEF_1E8F6F7AC575_
@@ -0,0 +1,105 @@
+#include "parallel.h"
+#include <framework/types/string.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace my {
+namespace ratings {
+namespace {
+
+class TaskQueue
+{
+public:
+	TaskQueue(size_t count, const boost::function<void (size_t)>& task)
+		: m_count(count)
+		, m_next(0)
+		, m_task(task)
+		, m_failed(false)
+	{
+	}
+
+public:
+	void Run()
+	{
+		size_t index = 0;
+		while (Pop(index))
+		{
+			try
+			{
+				m_task(index);
+			}
+			catch (std::exception& e)
+			{
+				SetError(e.what());
+			}
+		}
+	}
+
+	void Check() const
+	{
+		if (m_failed)
+			throw std::runtime_error(m_error);
+	}
+
+private:
+	bool Pop(size_t& index)
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		if (m_next == m_count)
+			return false;
+
+		index = m_next++;
+		return true;
+	}
+
+	void SetError(const string8_t& error)
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		if (!m_failed)
+		{
+			m_failed = true;
+			m_error = error;
+		}
+	}
+
+private:
+	const size_t m_count;
+	size_t m_next;
+	const boost::function<void (size_t)>& m_task;
+	boost::mutex m_mutex;
+	bool m_failed;
+	string8_t m_error;
+};
+
+} // namespace
+
+uint32_t GetNumWorkers()
+{
+	return std::max(boost::thread::hardware_concurrency(), 1u);
+}
+
+void ParallelFor(size_t count, const boost::function<void (size_t)>& task)
+{
+	TaskQueue queue(count, task);
+	size_t numThreads = std::min<size_t>(GetNumWorkers(), count);
+	if (numThreads <= 1)
+	{
+		queue.Run();
+	}
+	else
+	{
+		boost::thread_group threads;
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			threads.create_thread(boost::bind(&TaskQueue::Run, &queue));
+		}
+		threads.join_all();
+	}
+	queue.Check();
+}
+
+} // namespace ratings
+} // namespace my
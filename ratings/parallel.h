@@ -0,0 +1,19 @@
+#ifndef _06C26914_C695_44B9_9B68_DAB369F72B03_
+#define _06C26914_C695_44B9_9B68_DAB369F72B03_
+
+#include <framework/types/types.h>
+#include <boost/function.hpp>
+
+namespace my {
+namespace ratings {
+
+uint32_t GetNumWorkers();
+
+// Runs task(0) ... task(count - 1) on a pool of GetNumWorkers() threads.
+// Rethrows the first failure as std::runtime_error after every task has finished.
+void ParallelFor(size_t count, const boost::function<void (size_t)>& task);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _06C26914_C695_44B9_9B68_DAB369F72B03_
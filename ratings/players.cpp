@@ -0,0 +1,48 @@
+#include "players.h"
+#include <framework/rtl/expect.h>
+#include <boost/foreach.hpp>
+
+namespace my {
+namespace ratings {
+
+void PlayerRegistry::Register(Tournament& tournament)
+{
+	tournament.m_playerIds.clear();
+	BOOST_FOREACH(const Player& player, tournament.m_players)
+	{
+		tournament.m_playerIds.push_back(GetOrAdd(player));
+	}
+}
+
+PlayerId PlayerRegistry::GetId(const Player& player) const
+{
+	boost::unordered_map<Player, PlayerId>::const_iterator it = m_ids.find(player);
+	EXPECT(it != m_ids.end());
+	return it->second;
+}
+
+const string8_t& PlayerRegistry::GetName(PlayerId player) const
+{
+	EXPECT(player < m_names.size());
+	return m_names[player];
+}
+
+uint32_t PlayerRegistry::GetCount() const
+{
+	return m_names.size();
+}
+
+PlayerId PlayerRegistry::GetOrAdd(const Player& player)
+{
+	boost::unordered_map<Player, PlayerId>::const_iterator it = m_ids.find(player);
+	if (it != m_ids.end())
+		return it->second;
+
+	PlayerId id = m_names.size();
+	m_ids.insert(std::make_pair(player, id));
+	m_names.push_back(player.ToString());
+	return id;
+}
+
+} // namespace ratings
+} // namespace my
@@ -0,0 +1,34 @@
+#ifndef _8A04E69E_ABE3_4A63_ABDE_729EC409BABB_
+#define _8A04E69E_ABE3_4A63_ABDE_729EC409BABB_
+
+#include "basic.h"
+#include "tournament.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <boost/unordered_map.hpp>
+
+namespace my {
+namespace ratings {
+
+class PlayerRegistry
+{
+public:
+	void Register(Tournament& tournament);
+
+public:
+	PlayerId GetId(const Player& player) const;
+	const string8_t& GetName(PlayerId player) const;
+	uint32_t GetCount() const;
+
+private:
+	PlayerId GetOrAdd(const Player& player);
+
+private:
+	boost::unordered_map<Player, PlayerId> m_ids;
+	vector<string8_t> m_names;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _8A04E69E_ABE3_4A63_ABDE_729EC409BABB_
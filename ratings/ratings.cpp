@@ -1,34 +1,176 @@
 #include <ratings.h>
 #include "tournament.h"
+#include "tournament_cache.h"
+#include "activity.h"
 #include "engine.h"
+#include "players.h"
 #include "elo.h"
+#include "glicko2.h"
+#include "whr.h"
+#include "match_dataset.h"
+#include "bootstrap.h"
+#include "file_writer.h"
+#include "archive_writer.h"
+#include "archive_reader.h"
+#include <framework/system/file.h>
 #include <framework/system/filesystem.h>
-#include <boost/range/algorithm/sort.hpp>
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <algorithm>
+#include <iostream>
 
 namespace my {
 namespace ratings {
 
-void CalculateRatings(const string8_t& logDir, const string8_t& rootDir)
+namespace {
+
+const boost::gregorian::date_duration ActivityTimeout(183);
+
+struct LogFile
+{
+	string8_t m_filePath;
+	boost::gregorian::date m_date;
+};
+
+void CreateEngines(boost::ptr_vector<Engine>& engines, const PlayerRegistry& players, const vector<string8_t>& tags)
+{
+	engines.push_back(new Engine("elo", CreateEloSystem(StandartEloSettings()), players, tags));
+	engines.push_back(new Engine("glicko2", CreateGlicko2System(StandartGlicko2Settings()), players, tags));
+	engines.push_back(new Engine("whr", CreateWhrSystem(StandartWhrSettings()), players, tags));
+}
+
+// The intervals are written next to the Elo ratings they are the point estimates of; CreateEngines() puts Elo first.
+void Dump(boost::ptr_vector<Engine>& engines, const vector<PlayerId>& activePlayers, const MatchDataset& dataset, const PlayerRegistry& players, const string8_t& rootDir, const CalculationSettings& settings)
+{
+	boost::scoped_ptr<IOutput> writer;
+	if (settings.m_format == ArchiveOutput)
+	{
+		writer.reset(new ArchiveWriter(rootDir + "/ratings.archive", "./ratings"));
+	}
+	else
+	{
+		writer.reset(new FileWriter(rootDir + "/ratings.manifest", settings.m_removeStaleFiles));
+	}
+	BOOST_FOREACH(Engine& engine, engines)
+	{
+		engine.End(activePlayers, settings.m_activeRatingSize, settings.m_layout, *writer);
+	}
+	const Engine& elo = engines.front();
+	DumpRatingIntervals(dataset, StandartEloSettings(), elo.GetOverallRatings(), players, settings.m_numIntervalReplays, "./ratings/" + elo.GetName() + "/overall/rating_intervals.csv", *writer);
+	writer->Flush();
+	std::cout << writer->GetReport();
+}
+
+void CalculateInMemory(const string8_t& logDir, const string8_t& rootDir, const CalculationSettings& settings)
+{
+	vector<Tournament> tournaments = ReadTournaments(system::ListFiles(logDir), logDir + ".cache");
+	std::stable_sort(tournaments.begin(), tournaments.end(), boost::bind(&Tournament::m_date, _1) < boost::bind(&Tournament::m_date, _2));
+
+	PlayerRegistry players;
+	MatchDataset dataset;
+	BOOST_FOREACH(Tournament& tournament, tournaments)
+	{
+		players.Register(tournament);
+		if (settings.m_numIntervalReplays != 0)
+		{
+			AddTournament(dataset, tournament, players);
+		}
+	}
+	boost::gregorian::date_duration timeout = ActivityTimeout;
+	vector<PlayerId> activePlayers = my::ratings::GetActivePlayers(timeout, tournaments);
+
+	boost::ptr_vector<Engine> engines;
+	CreateEngines(engines, players, GetTags(tournaments));
+	BOOST_FOREACH(Engine& engine, engines)
+	{
+		string8_t checkpointFile = rootDir + "/" + engine.GetName() + ".checkpoint";
+		engine.LoadCheckpoint(checkpointFile, tournaments);
+		engine.ProcessTournaments(tournaments);
+		engine.SaveCheckpoint(checkpointFile, tournaments);
+	}
+
+	Dump(engines, activePlayers, dataset, players, rootDir, settings);
+}
+
+void CalculateStreaming(const string8_t& logDir, const string8_t& rootDir, const CalculationSettings& settings)
 {
-	vector<string8_t> tournamentFiles = system::ListFiles(logDir);
-	vector<Tournament> tournaments;
-	BOOST_FOREACH(const string8_t& fileName, tournamentFiles)
+	vector<LogFile> logs;
+	vector<Tournament> headers;
+	BOOST_FOREACH(const string8_t& filePath, system::ListFiles(logDir))
 	{
-		tournaments.push_back(ReadTournament(fileName));
+		headers.push_back(ReadTournamentHeader(filePath));
+		LogFile log;
+		log.m_filePath = filePath;
+		log.m_date = headers.back().m_date;
+		logs.push_back(log);
 	}
-	boost::sort(tournaments, boost::bind(&Tournament::m_date, _1) < boost::bind(&Tournament::m_date, _2));
-	vector<string8_t> activePlayers = my::ratings::GetActivePlayers(boost::gregorian::date_duration(183), tournaments);
+	std::stable_sort(logs.begin(), logs.end(), boost::bind(&LogFile::m_date, _1) < boost::bind(&LogFile::m_date, _2));
+
+	PlayerRegistry players;
+	ActivityTracker activity;
+	MatchDataset dataset;
+	boost::ptr_vector<Engine> engines;
+	CreateEngines(engines, players, GetTags(headers));
+	BOOST_FOREACH(const LogFile& log, logs)
+	{
+		Tournament tournament = ReadTournament(log.m_filePath);
+		players.Register(tournament);
+		activity.Add(tournament);
+		if (settings.m_numIntervalReplays != 0)
+		{
+			AddTournament(dataset, tournament, players);
+		}
+		BOOST_FOREACH(Engine& engine, engines)
+		{
+			engine.ProcessTournament(tournament);
+		}
+	}
+
+	Dump(engines, activity.GetActivePlayers(ActivityTimeout), dataset, players, rootDir, settings);
+}
+
+} // namespace
+
+CalculationSettings::CalculationSettings(ProcessingMode mode, OutputFormat format, HistoryLayout layout, uint32_t activeRatingSize, uint32_t numIntervalReplays,
+	bool removeStaleFiles)
+	: m_mode(mode)
+	, m_format(format)
+	, m_layout(layout)
+	, m_activeRatingSize(activeRatingSize)
+	, m_numIntervalReplays(numIntervalReplays)
+	, m_removeStaleFiles(removeStaleFiles)
+{
+}
 
-	Engine elo("elo", CreateEloSystem(StandartEloSettings()));
+CalculationSettings StandartCalculationSettings()
+{
+	return CalculationSettings(InMemoryProcessing, CsvOutput, DenseHistory, AllPlayers, 0, false);
+}
 
-	BOOST_FOREACH(const Tournament& tournament, tournaments)
+void CalculateRatings(const string8_t& logDir, const string8_t& rootDir, const CalculationSettings& settings)
+{
+	if (settings.m_mode == StreamingProcessing)
 	{
-		elo.ProcessTournament(tournament);
+		CalculateStreaming(logDir, rootDir, settings);
 	}
+	else
+	{
+		CalculateInMemory(logDir, rootDir, settings);
+	}
+}
 
-	elo.End(activePlayers);
+void ExtractArchive(const string8_t& rootDir)
+{
+	ArchiveReader reader(rootDir + "/ratings.archive");
+	BOOST_FOREACH(const ArchiveEntry& entry, reader.GetEntries())
+	{
+		boost::filesystem::path filePath = boost::filesystem::path(rootDir + "/ratings") / entry.m_view / entry.m_name;
+		boost::filesystem::create_directories(filePath.parent_path());
+		system::SaveToFile(filePath.string(), string8_t(entry.m_data, entry.m_data + entry.m_size));
+	}
 }
 
 } // namespace ratings
@@ -1,16 +1,23 @@
 #ifndef _ED54FAC2_CBA4_4029_B28D_63F45D1D1013_
 #define _ED54FAC2_CBA4_4029_B28D_63F45D1D1013_
 
+#include "basic.h"
+#include <ratings.h>
 #include <framework/types/string.h>
+#include <framework/types/vector.h>
 #include <framework/types/types.h>
 #include <memory>
 
 namespace my {
 namespace ratings {
 
+class PlayerRegistry;
+struct IOutput;
+class BinaryReader;
+
 struct ITournament
 {
-	virtual void AddMatch(const string8_t& playerA, const string8_t& playerB, uint32_t scoreA, uint32_t scoreB) = 0;
+	virtual void AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB) = 0;
 	virtual void End() = 0;
 
 	virtual ~ITournament() { }
@@ -19,15 +26,21 @@ struct ITournament
 struct ISeason
 {
 	virtual std::auto_ptr<ITournament> NewTournament(const string8_t& name, uint32_t pointsPerMatch) = 0;
-	virtual void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir) = 0;
-	virtual void DumpActiveRating(const string8_t& ratingFile, const vector<string8_t>& activePlayers) = 0;
+	// Brings up to date what the season derives from all its tournaments at once; returns a report, empty if there was nothing to do.
+	virtual string8_t Update() = 0;
+	virtual void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir, HistoryLayout layout, IOutput& writer) = 0;
+	// Final standings of the season, best first.
+	virtual vector<Rating> GetRatings() const = 0;
+	virtual void DumpActiveRating(const string8_t& ratingFile, const vector<PlayerId>& activePlayers, uint32_t maxCount, IOutput& writer) = 0;
+	virtual void Save(string8_t& output) const = 0;
+	virtual void Load(BinaryReader& reader) = 0;
 
 	virtual ~ISeason() { }
 };
 
 struct ISystem
 {
-	virtual std::auto_ptr<ISeason> NewSeason() = 0;
+	virtual std::auto_ptr<ISeason> NewSeason(const PlayerRegistry& players) = 0;
 
 	virtual ~ISystem() { }
 };
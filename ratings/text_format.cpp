@@ -0,0 +1,88 @@
+#include "text_format.h"
+#include <framework/rtl/formatting.h>
+#include <cmath>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const int MaxFastDigitsAfterDot = 9;
+const double MaxFastValue = 1e15;
+const uint32_t PowersOf10[MaxFastDigitsAfterDot + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+// Scaled fractions closer than this to a half may be rounded the other way than by printf, which rounds the exact binary value.
+const double TieMargin = 1e-6;
+
+bool IsNegative(double value)
+{
+	return value < 0 || (value == 0 && 1/value < 0);
+}
+
+void AppendPadded(string8_t& output, uint32_t value, int numDigits)
+{
+	char buffer[MaxFastDigitsAfterDot];
+	for (int i = numDigits - 1; i >= 0; --i)
+	{
+		buffer[i] = char('0' + value % 10);
+		value /= 10;
+	}
+	output.append(buffer, buffer + numDigits);
+}
+
+} // namespace
+
+void AppendInteger(string8_t& output, uint64_t value)
+{
+	char buffer[20];
+	char* end = buffer + sizeof(buffer);
+	char* begin = end;
+	do
+	{
+		*--begin = char('0' + value % 10);
+		value /= 10;
+	}
+	while (value != 0);
+	output.append(begin, end);
+}
+
+void AppendFixed(string8_t& output, double value, int digitsAfterDot)
+{
+	double magnitude = fabs(value);
+	if (!(magnitude < MaxFastValue) || digitsAfterDot < 0 || digitsAfterDot > MaxFastDigitsAfterDot)
+	{
+		output += ToString(value, digitsAfterDot);
+		return;
+	}
+
+	double integral = floor(magnitude);
+	double scaled = (magnitude - integral) * PowersOf10[digitsAfterDot];
+	double fraction = floor(scaled);
+	double remainder = scaled - fraction;
+	if (fabs(remainder - 0.5) < TieMargin)
+	{
+		output += ToString(value, digitsAfterDot);
+		return;
+	}
+
+	uint64_t integerPart = uint64_t(integral);
+	uint32_t fractionPart = uint32_t(fraction) + (remainder > 0.5 ? 1 : 0);
+	if (fractionPart == PowersOf10[digitsAfterDot])
+	{
+		fractionPart = 0;
+		++integerPart;
+	}
+
+	if (IsNegative(value))
+	{
+		output += '-';
+	}
+	AppendInteger(output, integerPart);
+	if (digitsAfterDot > 0)
+	{
+		output += '.';
+		AppendPadded(output, fractionPart, digitsAfterDot);
+	}
+}
+
+} // namespace ratings
+} // namespace my
@@ -0,0 +1,17 @@
+#ifndef _5D4A33C8_6857_4264_9287_56B49079003A_
+#define _5D4A33C8_6857_4264_9287_56B49079003A_
+
+#include <framework/types/string.h>
+#include <framework/types/types.h>
+
+namespace my {
+namespace ratings {
+
+// Append the same text as ToString(value) and ToString(value, digitsAfterDot) without temporary strings.
+void AppendInteger(string8_t& output, uint64_t value);
+void AppendFixed(string8_t& output, double value, int digitsAfterDot);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _5D4A33C8_6857_4264_9287_56B49079003A_
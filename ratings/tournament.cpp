@@ -1,196 +1,400 @@
 #include "tournament.h"
+#include "xml_reader.h"
+#include "parallel.h"
+#include "hash.h"
 #include <framework/rtl/expect.h>
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/algorithm/string/find.hpp>
 #include <boost/range/algorithm.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <limits>
+#include <stdexcept>
 
 namespace my {
 namespace ratings {
 
-Player::Player(const string8_t& fullName)
+namespace {
+
+// Folds the spelling variations of a name part: drops spaces and replaces cyrillic "yo" (U+0451) with "ye" (U+0435).
+string8_t NormalizeNamePart(const string8_t& text)
 {
-	size_t it = fullName.find(" ");
-	m_firstName = ConvertTo16(fullName.substr(0, it));
-	m_secondName = ConvertTo16(fullName.substr(it+1));
-	boost::replace_all(m_firstName, TEXT16(""), TEXT16(""));
-	boost::replace_all(m_secondName, TEXT16(""), TEXT16(""));
-	boost::replace_all(m_firstName, TEXT16(" "), TEXT16(""));
-	boost::replace_all(m_secondName, TEXT16(" "), TEXT16(""));
+	string8_t result;
+	result.reserve(text.size());
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		char c = text[i];
+		if (c == ' ')
+			continue;
+
+		if (c == '\xD1' && i + 1 < text.size() && text[i + 1] == '\x91')
+		{
+			result += "\xD0\xB5";
+			++i;
+			continue;
+		}
+		result += c;
+	}
+	return result;
 }
 
-Player::Player(const string8_t& firstName, const string8_t& secondName)
-	: m_firstName(ConvertTo16(firstName))
-	, m_secondName(ConvertTo16(secondName))
+uint32_t ParseNumber(const string8_t& text, uint32_t maxValue)
 {
+	size_t begin = text.find_first_not_of(" \t\r\n");
+	size_t end = text.find_last_not_of(" \t\r\n");
+	EXPECT(begin != string8_t::npos);
+
+	uint64_t value = 0;
+	for (size_t i = begin; i <= end; ++i)
+	{
+		EXPECT(text[i] >= '0' && text[i] <= '9');
+		value = value * 10 + (text[i] - '0');
+		EXPECT(value <= maxValue);
+	}
+	return uint32_t(value);
 }
 
-bool Player::operator<(const Player& rhv) const
+void ReadHeader(XmlReader& reader, Tournament& result)
 {
-	bool reverseLhv = (m_firstName < m_secondName);
-	bool reverseRhv = (rhv.m_firstName < rhv.m_secondName);
-	const string16_t& lhv1 = (reverseLhv ? m_secondName : m_firstName);
-	const string16_t& lhv2 = (reverseLhv ? m_firstName : m_secondName);
-	const string16_t& rhv1 = (reverseRhv ? rhv.m_secondName : rhv.m_firstName);
-	const string16_t& rhv2 = (reverseRhv ? rhv.m_firstName : rhv.m_secondName);
+	bool hasDate = false;
+	bool hasPointsPerMatch = false;
+	bool hasTags = false;
+	result.m_endOfSeason = false;
+	while (reader.ReadStartElement())
+	{
+		if (reader.GetName() == "date" && !hasDate)
+		{
+			result.m_date = boost::gregorian::from_string(reader.ReadText());
+			hasDate = true;
+		}
+		else if (reader.GetName() == "end_of_season")
+		{
+			reader.SkipElement();
+			result.m_endOfSeason = true;
+		}
+		else if (reader.GetName() == "points_per_match" && !hasPointsPerMatch)
+		{
+			result.m_pointsPerMatch = ParseNumber(reader.ReadText(), std::numeric_limits<uint32_t>::max());
+			hasPointsPerMatch = true;
+		}
+		else if (reader.GetName() == "tags" && !hasTags)
+		{
+			while (reader.ReadStartElement())
+			{
+				result.m_tags.push_back(reader.ReadText());
+			}
+			hasTags = true;
+		}
+		else
+		{
+			reader.SkipElement();
+		}
+	}
+	EXPECT(hasDate);
+	EXPECT(hasPointsPerMatch);
+	EXPECT(hasTags);
+	EXPECT(!result.m_tags.empty());
+}
 
-	if (lhv1 == rhv1)
-		return lhv2 < rhv2;
-	return lhv1 < rhv1;
+void ReadGames(XmlReader& reader, vector<Game>& games)
+{
+	while (reader.ReadStartElement())
+	{
+		bool hasScore1 = false;
+		bool hasScore2 = false;
+		uint8_t score1 = 0;
+		uint8_t score2 = 0;
+		while (reader.ReadStartElement())
+		{
+			if (reader.GetName() == "score1" && !hasScore1)
+			{
+				score1 = uint8_t(ParseNumber(reader.ReadText(), std::numeric_limits<uint8_t>::max()));
+				hasScore1 = true;
+			}
+			else if (reader.GetName() == "score2" && !hasScore2)
+			{
+				score2 = uint8_t(ParseNumber(reader.ReadText(), std::numeric_limits<uint8_t>::max()));
+				hasScore2 = true;
+			}
+			else
+			{
+				reader.SkipElement();
+			}
+		}
+		EXPECT(hasScore1);
+		EXPECT(hasScore2);
+		games.push_back(Game(score1, score2));
+	}
 }
 
-bool Player::operator==(const Player& rhv) const
+uint32_t GetPlayerIndex(const string8_t& name, Tournament& result, boost::unordered_map<Player, uint32_t>& indexes)
 {
-	return (m_firstName == rhv.m_firstName && m_secondName == rhv.m_secondName) ||
-		(m_firstName == rhv.m_secondName && m_secondName == rhv.m_firstName);
+	Player player(name);
+	boost::unordered_map<Player, uint32_t>::const_iterator it = indexes.find(player);
+	if (it != indexes.end())
+		return it->second;
+
+	uint32_t index = result.m_players.size();
+	indexes.insert(std::make_pair(player, index));
+	result.m_players.push_back(player);
+	return index;
 }
 
-string8_t Player::ToString() const
+void ReadMatches(XmlReader& reader, Tournament& result)
 {
-	string8_t a = ConvertTo8(m_firstName);
-	string8_t b = ConvertTo8(m_secondName);
-	string8_t c = a + " " + b;
-	return c;
+	string8_t player1;
+	string8_t player2;
+	vector<Game> games;
+	boost::unordered_map<Player, uint32_t> indexes;
+	while (reader.ReadStartElement())
+	{
+		bool hasPlayer1 = false;
+		bool hasPlayer2 = false;
+		bool hasGames = false;
+		games.clear();
+		while (reader.ReadStartElement())
+		{
+			if (reader.GetName() == "player1" && !hasPlayer1)
+			{
+				player1 = reader.ReadText();
+				hasPlayer1 = true;
+			}
+			else if (reader.GetName() == "player2" && !hasPlayer2)
+			{
+				player2 = reader.ReadText();
+				hasPlayer2 = true;
+			}
+			else if (reader.GetName() == "games" && !hasGames)
+			{
+				ReadGames(reader, games);
+				hasGames = true;
+			}
+			else
+			{
+				reader.SkipElement();
+			}
+		}
+		EXPECT(hasPlayer1);
+		EXPECT(hasPlayer2);
+		EXPECT(hasGames);
+
+		uint32_t index1 = GetPlayerIndex(player1, result, indexes);
+		uint32_t index2 = GetPlayerIndex(player2, result, indexes);
+		result.AddMatch(index1, index2);
+		BOOST_FOREACH(const Game& game, games)
+		{
+			result.AddGame(game.m_score1, game.m_score2);
+		}
+	}
 }
 
+void ReadTournamentTask(const vector<string8_t>& filePaths, vector<Tournament>& tournaments, vector<string8_t>& errors, size_t index)
+{
+	try
+	{
+		tournaments[index] = ReadTournament(filePaths[index]);
+	}
+	catch (std::exception& e)
+	{
+		errors[index] = e.what();
+	}
+}
 
-Tournament ReadTournament(const string8_t& filePath)
+Tournament ReadTournamentFile(const string8_t& filePath, bool headerOnly)
 {
-	using namespace boost::property_tree;
+	using namespace boost::interprocess;
 
 	Tournament result;
 	result.m_name = string8_t(boost::find_last(filePath, "/").begin() + 1, filePath.end() - 4);
 
-	ptree xmlDocument;
-	read_xml(filePath, xmlDocument);
-	const ptree& root = xmlDocument.get_child("root");
+	file_mapping file(filePath.c_str(), read_only);
+	mapped_region region(file, read_only);
+	const char* data = static_cast<const char*>(region.get_address());
+	XmlReader reader(data, data + region.get_size());
 
-	const ptree& header = root.get_child("header");
-	result.m_date = boost::gregorian::from_string(header.get<string8_t>("date"));
-	result.m_endOfSeason = header.get_optional<string8_t>("end_of_season").is_initialized();
-	result.m_pointsPerMatch = header.get<uint32_t>("points_per_match");
-	BOOST_FOREACH(const ptree::value_type& tag, header.get_child("tags"))
+	EXPECT(reader.ReadStartElement() && reader.GetName() == "root");
+	bool hasHeader = false;
+	bool hasMatches = false;
+	while (reader.ReadStartElement())
 	{
-		result.m_tags.push_back(tag.second.get<string8_t>(""));
-	}
-	EXPECT(!result.m_tags.empty());
-	
-	vector<Player> players;
-	BOOST_FOREACH(const ptree::value_type& match, root.get_child("matches"))
-	{
-		Match currentMatch(match.second.get<string8_t>("player1"), match.second.get<string8_t>("player2"));
-		players.push_back(currentMatch.m_player1);
-		players.push_back(currentMatch.m_player2);
-		
-		BOOST_FOREACH(const ptree::value_type& game, match.second.get_child("games"))
+		if (reader.GetName() == "header")
 		{
-			uint8_t score1 = game.second.get<uint8_t>("score1");
-			uint8_t score2 = game.second.get<uint8_t>("score2");
-			currentMatch.m_games.push_back(Game(score1, score2));
+			ReadHeader(reader, result);
+			hasHeader = true;
+			if (headerOnly)
+				return result;
+		}
+		else if (reader.GetName() == "matches")
+		{
+			ReadMatches(reader, result);
+			hasMatches = true;
+		}
+		else
+		{
+			reader.SkipElement();
 		}
-		result.m_matches.push_back(currentMatch);
 	}
-
-	boost::sort(players);
-	boost::iterator_range<vector<Player>::iterator> uniquePlayers = boost::unique(players);
-	result.m_players = vector<Player>(uniquePlayers.begin(), uniquePlayers.end());
+	EXPECT(hasHeader);
+	EXPECT(hasMatches);
 	return result;
 }
 
-vector<Player> GetPlayers(const vector<Tournament>& tournaments)
+} // namespace
+
+Player::Player(const string8_t& fullName)
 {
-	vector<Player> players;
-	BOOST_FOREACH(const Tournament& tournament, tournaments)
+	size_t it = fullName.find(" ");
+	Init(fullName.substr(0, it), fullName.substr(it+1));
+}
+
+Player::Player(const string8_t& firstName, const string8_t& secondName)
+{
+	Init(firstName, secondName);
+}
+
+void Player::Init(const string8_t& firstName, const string8_t& secondName)
+{
+	string8_t first = NormalizeNamePart(firstName);
+	string8_t second = NormalizeNamePart(secondName);
+	m_name = first + " " + second;
+
+	m_key = (first < second ? second + " " + first : m_name);
+	m_hash = CalculateHash(m_key);
+}
+
+bool Player::operator<(const Player& rhv) const
+{
+	if (m_hash != rhv.m_hash)
+		return m_hash < rhv.m_hash;
+	return m_key < rhv.m_key;
+}
+
+bool Player::operator==(const Player& rhv) const
+{
+	return m_hash == rhv.m_hash && m_key == rhv.m_key;
+}
+
+const string8_t& Player::ToString() const
+{
+	return m_name;
+}
+
+uint64_t Player::GetHash() const
+{
+	return m_hash;
+}
+
+std::size_t hash_value(const Player& player)
+{
+	return std::size_t(player.GetHash());
+}
+
+uint32_t Tournament::GetNumMatches() const
+{
+	return m_gamesEnd.size();
+}
+
+Match Tournament::GetMatch(uint32_t match) const
+{
+	EXPECT(match < GetNumMatches());
+	uint32_t player1 = m_matchPlayers[2 * match];
+	uint32_t player2 = m_matchPlayers[2 * match + 1];
+	Match result(m_players[player1], m_players[player2]);
+	if (m_playerIds.size() == m_players.size())
 	{
-		BOOST_FOREACH(const Player& player, tournament.m_players)
-		{
-			if (boost::range::find(players, player) == players.end())
-			{
-				players.push_back(player);
-			}
-		}
+		result.m_playerId1 = m_playerIds[player1];
+		result.m_playerId2 = m_playerIds[player2];
 	}
-	return players;
+
+	for (uint32_t game = (match == 0 ? 0 : m_gamesEnd[match - 1]); game < m_gamesEnd[match]; ++game)
+	{
+		result.m_games.push_back(Game(m_gameScores[2 * game], m_gameScores[2 * game + 1]));
+	}
+	return result;
 }
 
-vector<string8_t> GetActivePlayers(boost::gregorian::date_duration& timeout, const vector<Tournament>& tournaments)
+void Tournament::AddMatch(uint32_t player1, uint32_t player2)
 {
-	struct Tag
-	{
-		Tag(const string8_t& name, const boost::gregorian::date& date) : m_name(name), m_date(date) { }
+	EXPECT(player1 < m_players.size() && player2 < m_players.size());
+	m_matchPlayers.push_back(player1);
+	m_matchPlayers.push_back(player2);
+	m_matchScores.push_back(0);
+	m_matchScores.push_back(0);
+	m_gamesEnd.push_back(m_gameScores.size() / 2);
+}
 
-		string8_t m_name;
-		boost::gregorian::date m_date;
-	};
+void Tournament::AddGame(uint8_t score1, uint8_t score2)
+{
+	EXPECT(!m_gamesEnd.empty());
+	m_gameScores.push_back(score1);
+	m_gameScores.push_back(score2);
+	m_matchScores[m_matchScores.size() - 2] += score1;
+	m_matchScores[m_matchScores.size() - 1] += score2;
+	++m_gamesEnd.back();
+}
 
-	struct PlayerTags
-	{
-		explicit PlayerTags(const Player& name) : m_name(name) { }
 
-		Player m_name;
-		vector<Tag> m_tags;
-	};
+Tournament ReadTournament(const string8_t& filePath)
+{
+	return ReadTournamentFile(filePath, false);
+}
+
+Tournament ReadTournamentHeader(const string8_t& filePath)
+{
+	return ReadTournamentFile(filePath, true);
+}
 
-	vector<PlayerTags> players;
-	vector<Tag> lastTournaments;
+vector<Tournament> ReadTournaments(const vector<string8_t>& filePaths)
+{
+	vector<Tournament> tournaments(filePaths.size());
+	vector<string8_t> errors(filePaths.size());
+	ParallelFor(filePaths.size(), boost::bind(&ReadTournamentTask, boost::cref(filePaths), boost::ref(tournaments), boost::ref(errors), _1));
 
-	BOOST_FOREACH(const Tournament& tournament, tournaments)
+	string8_t errorText;
+	for (size_t i = 0; i < filePaths.size(); ++i)
 	{
-		const vector<Player>& currentPlayers = tournament.m_players;
-		const boost::gregorian::date& currentDate = tournament.m_date;
-		BOOST_FOREACH(const Player& currentPlayer, currentPlayers)
+		if (!errors[i].empty())
 		{
-			vector<PlayerTags>::iterator playerIt = boost::find_if(players, boost::bind(&PlayerTags::m_name, _1) == currentPlayer);
-			if (playerIt == players.end())
-			{
-				players.push_back(PlayerTags(currentPlayer));
-				playerIt = players.end() - 1;
-			}
-
-			BOOST_FOREACH(const string8_t& tag, tournament.m_tags)
-			{
-				vector<Tag>::iterator cityIt = boost::find_if(playerIt->m_tags, boost::bind(&Tag::m_name, _1) == tag);
-				if (cityIt != playerIt->m_tags.end())
-				{
-					*cityIt = Tag(tag, currentDate);
-				}
-				else
-				{
-					playerIt->m_tags.push_back(Tag(tag, currentDate));
-				}
-			}
-
-			BOOST_FOREACH(const string8_t& tag, tournament.m_tags)
-			{
-				vector<Tag>::iterator tagIt = boost::find_if(lastTournaments, boost::bind(&Tag::m_name, _1) == tag);
-				if (tagIt != lastTournaments.end())
-				{
-					*tagIt = Tag(tag, currentDate);
-				}
-				else
-				{
-					lastTournaments.push_back(Tag(tag, currentDate));
-				}
-			}
+			errorText += filePaths[i] + ": " + errors[i] + "\n";
 		}
 	}
+	if (!errorText.empty())
+		throw std::runtime_error(errorText);
+
+	return tournaments;
+}
 
-	vector<string8_t> result;
-	BOOST_FOREACH(const PlayerTags& player, players)
+vector<Player> GetPlayers(const vector<Tournament>& tournaments)
+{
+	vector<Player> players;
+	boost::unordered_set<Player> knownPlayers;
+	BOOST_FOREACH(const Tournament& tournament, tournaments)
 	{
-		BOOST_FOREACH(const Tag& tag, player.m_tags)
+		BOOST_FOREACH(const Player& player, tournament.m_players)
 		{
-			const boost::gregorian::date& lastTournament = boost::find_if(lastTournaments, boost::bind(&Tag::m_name, _1) == tag.m_name)->m_date;
-			if ((lastTournament - timeout) < tag.m_date)
+			if (knownPlayers.insert(player).second)
 			{
-				result.push_back(player.m_name.ToString());
-				break;
+				players.push_back(player);
 			}
 		}
 	}
+	return players;
+}
 
-	return result;
+vector<string8_t> GetTags(const vector<Tournament>& tournaments)
+{
+	vector<string8_t> tags;
+	BOOST_FOREACH(const Tournament& tournament, tournaments)
+	{
+		tags.insert(tags.end(), tournament.m_tags.begin(), tournament.m_tags.end());
+	}
+	boost::sort(tags);
+	tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+	return tags;
 }
 
 } // namespace ratings
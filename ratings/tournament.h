@@ -1,6 +1,7 @@
 #ifndef _1579D6DD_5CF7_4D4B_ADD7_F60AC8917092_
 #define _1579D6DD_5CF7_4D4B_ADD7_F60AC8917092_
 
+#include "basic.h"
 #include <framework/types/string.h>
 #include <framework/types/vector.h>
 #include <framework/types/types.h>
@@ -20,13 +21,20 @@ public:
 	bool operator==(const Player& rhv) const;
 
 public:
-	string8_t ToString() const;
+	const string8_t& ToString() const;
+	uint64_t GetHash() const;
 
 private:
-	string16_t m_firstName;
-	string16_t m_secondName;
+	void Init(const string8_t& firstName, const string8_t& secondName);
+
+private:
+	string8_t m_name;
+	string8_t m_key;
+	uint64_t m_hash;
 };
 
+std::size_t hash_value(const Player& player);
+
 struct Game
 {
 	Game(uint8_t score1, uint8_t score2)
@@ -44,29 +52,55 @@ struct Match
 	Match(const string8_t& player1, const string8_t& player2)
 		: m_player1(player1)
 		, m_player2(player2)
+		, m_playerId1(InvalidPlayerId)
+		, m_playerId2(InvalidPlayerId)
+	{
+	}
+
+	Match(const Player& player1, const Player& player2)
+		: m_player1(player1)
+		, m_player2(player2)
+		, m_playerId1(InvalidPlayerId)
+		, m_playerId2(InvalidPlayerId)
 	{
 	}
 
 	Player m_player1;
 	Player m_player2;
+	PlayerId m_playerId1;
+	PlayerId m_playerId2;
 	vector<Game> m_games;
 };
 
+// Matches are kept as flat arrays. m_matchPlayers holds two indexes into m_players per match, m_matchScores the two summed scores.
+// Games of match i are the score pairs from m_gamesEnd[i - 1] to m_gamesEnd[i] in m_gameScores.
+// m_players lists every player once, in order of first appearance.
 struct Tournament
 {
+	uint32_t GetNumMatches() const;
+	Match GetMatch(uint32_t match) const;
+	void AddMatch(uint32_t player1, uint32_t player2);
+	void AddGame(uint8_t score1, uint8_t score2);
+
 	string8_t m_name;
 	boost::gregorian::date m_date;
 	vector<string8_t> m_tags;
-	vector<Match> m_matches;
 	vector<Player> m_players;
+	vector<PlayerId> m_playerIds;
+	vector<uint32_t> m_matchPlayers;
+	vector<uint32_t> m_matchScores;
+	vector<uint32_t> m_gamesEnd;
+	vector<uint8_t> m_gameScores;
 	bool m_endOfSeason;
 	uint32_t m_pointsPerMatch;
 };
 
 Tournament ReadTournament(const string8_t& filePath);
+Tournament ReadTournamentHeader(const string8_t& filePath);
+vector<Tournament> ReadTournaments(const vector<string8_t>& filePaths);
 
 vector<Player> GetPlayers(const vector<Tournament>& tournaments);
-vector<string8_t> GetActivePlayers(boost::gregorian::date_duration& timeout, const vector<Tournament>& tournaments);
+vector<string8_t> GetTags(const vector<Tournament>& tournaments);
 
 } // namespace ratings
 } // namespace my
@@ -0,0 +1,268 @@
+#include "tournament_cache.h"
+#include "hash.h"
+#include "binary.h"
+#include <framework/system/file.h>
+#include <framework/rtl/expect.h>
+#include <boost/filesystem/operations.hpp>
+#include <boost/foreach.hpp>
+#include <cstring>
+#include <ctime>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const char Magic[] = "LCGTRNC";
+const uint32_t Version = 2;
+
+uint64_t CalculateFileHash(const string8_t& filePath, uint64_t size)
+{
+	using namespace boost::interprocess;
+
+	if (size == 0)
+		return CalculateHash(string8_t());
+
+	file_mapping file(filePath.c_str(), read_only);
+	mapped_region region(file, read_only);
+	return CalculateHash(static_cast<const char*>(region.get_address()), region.get_size());
+}
+
+LogFileInfo GetFileStatus(const string8_t& filePath)
+{
+	LogFileInfo info;
+	info.m_size = boost::filesystem::file_size(filePath);
+	info.m_modificationTime = boost::filesystem::last_write_time(filePath);
+	info.m_hash = 0;
+	return info;
+}
+
+string8_t EncodeTournament(const Tournament& tournament)
+{
+	string8_t output;
+	AppendString(output, tournament.m_name);
+	Append(output, uint16_t(tournament.m_date.year()));
+	Append(output, uint8_t(tournament.m_date.month()));
+	Append(output, uint8_t(tournament.m_date.day()));
+	Append(output, uint8_t(tournament.m_endOfSeason));
+	Append(output, tournament.m_pointsPerMatch);
+
+	Append(output, uint32_t(tournament.m_tags.size()));
+	BOOST_FOREACH(const string8_t& tag, tournament.m_tags)
+	{
+		AppendString(output, tag);
+	}
+
+	Append(output, uint32_t(tournament.m_players.size()));
+	BOOST_FOREACH(const Player& player, tournament.m_players)
+	{
+		AppendString(output, player.ToString());
+	}
+
+	AppendVector(output, tournament.m_matchPlayers);
+	AppendVector(output, tournament.m_gamesEnd);
+	AppendVector(output, tournament.m_gameScores);
+	return output;
+}
+
+Tournament DecodeTournament(const char* data, uint32_t size)
+{
+	BinaryReader reader(data, data + size);
+
+	Tournament tournament;
+	tournament.m_name = reader.ReadString();
+	uint16_t year = reader.Read<uint16_t>();
+	uint8_t month = reader.Read<uint8_t>();
+	uint8_t day = reader.Read<uint8_t>();
+	tournament.m_date = boost::gregorian::date(year, month, day);
+	tournament.m_endOfSeason = (reader.Read<uint8_t>() != 0);
+	tournament.m_pointsPerMatch = reader.Read<uint32_t>();
+
+	uint32_t numTags = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < numTags; ++i)
+	{
+		tournament.m_tags.push_back(reader.ReadString());
+	}
+
+	uint32_t numPlayers = reader.Read<uint32_t>();
+	tournament.m_players.reserve(numPlayers);
+	for (uint32_t i = 0; i < numPlayers; ++i)
+	{
+		tournament.m_players.push_back(Player(reader.ReadString()));
+	}
+
+	reader.ReadVector(tournament.m_matchPlayers);
+	reader.ReadVector(tournament.m_gamesEnd);
+	reader.ReadVector(tournament.m_gameScores);
+	EXPECT(tournament.m_matchPlayers.size() == 2 * tournament.m_gamesEnd.size());
+	BOOST_FOREACH(uint32_t player, tournament.m_matchPlayers)
+	{
+		EXPECT(player < numPlayers);
+	}
+
+	tournament.m_matchScores.assign(tournament.m_matchPlayers.size(), 0);
+	uint32_t game = 0;
+	for (uint32_t i = 0; i < tournament.m_gamesEnd.size(); ++i)
+	{
+		EXPECT(game <= tournament.m_gamesEnd[i] && tournament.m_gamesEnd[i] <= tournament.m_gameScores.size() / 2);
+		for (; game < tournament.m_gamesEnd[i]; ++game)
+		{
+			tournament.m_matchScores[2 * i] += tournament.m_gameScores[2 * game];
+			tournament.m_matchScores[2 * i + 1] += tournament.m_gameScores[2 * game + 1];
+		}
+	}
+	EXPECT(2 * game == tournament.m_gameScores.size());
+	EXPECT(reader.IsEnd());
+	return tournament;
+}
+
+} // namespace
+
+TournamentCache::TournamentCache(const string8_t& cacheFile)
+	: m_cacheFile(cacheFile)
+	, m_savedTime(0)
+	, m_numOutputEntries(0)
+	, m_isChanged(false)
+{
+	try
+	{
+		Load();
+	}
+	catch (std::exception&)
+	{
+		m_entries.clear();
+		m_region.reset();
+		m_file.reset();
+	}
+}
+
+bool TournamentCache::Read(const string8_t& filePath, Tournament& tournament)
+{
+	boost::unordered_map<string8_t, Entry>::const_iterator it = m_entries.find(filePath);
+	if (it == m_entries.end())
+		return false;
+
+	LogFileInfo info = GetFileStatus(filePath);
+	const Entry& entry = it->second;
+	if (info.m_size != entry.m_info.m_size)
+		return false;
+
+	if (info.m_modificationTime == entry.m_info.m_modificationTime && info.m_modificationTime < m_savedTime)
+	{
+		info.m_hash = entry.m_info.m_hash;
+	}
+	else
+	{
+		info.m_hash = CalculateFileHash(filePath, info.m_size);
+		if (info.m_hash != entry.m_info.m_hash)
+			return false;
+		m_isChanged = true;
+	}
+
+	try
+	{
+		tournament = DecodeTournament(entry.m_data, entry.m_size);
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+
+	AppendEntry(filePath, info, entry.m_data, entry.m_size);
+	return true;
+}
+
+void TournamentCache::Write(const string8_t& filePath, const Tournament& tournament)
+{
+	LogFileInfo info = GetFileStatus(filePath);
+	info.m_hash = CalculateFileHash(filePath, info.m_size);
+	string8_t data = EncodeTournament(tournament);
+	AppendEntry(filePath, info, data.data(), data.size());
+	m_isChanged = true;
+}
+
+void TournamentCache::Save()
+{
+	if (!m_isChanged && m_numOutputEntries == m_entries.size())
+		return;
+
+	m_entries.clear();
+	m_region.reset();
+	m_file.reset();
+
+	string8_t header(Magic, Magic + sizeof(Magic));
+	Append(header, Version);
+	Append(header, int64_t(std::time(0)));
+	Append(header, m_numOutputEntries);
+	system::SaveToFile(m_cacheFile, header + m_output);
+}
+
+void TournamentCache::Load()
+{
+	using namespace boost::interprocess;
+
+	if (!boost::filesystem::exists(m_cacheFile) || boost::filesystem::file_size(m_cacheFile) == 0)
+		return;
+
+	m_file.reset(new file_mapping(m_cacheFile.c_str(), read_only));
+	m_region.reset(new mapped_region(*m_file, read_only));
+	const char* data = static_cast<const char*>(m_region->get_address());
+	BinaryReader reader(data, data + m_region->get_size());
+
+	EXPECT(memcmp(reader.Skip(sizeof(Magic)), Magic, sizeof(Magic)) == 0);
+	EXPECT(reader.Read<uint32_t>() == Version);
+	m_savedTime = reader.Read<int64_t>();
+	uint32_t numEntries = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < numEntries; ++i)
+	{
+		string8_t filePath = reader.ReadString();
+		Entry entry;
+		entry.m_info.m_size = reader.Read<uint64_t>();
+		entry.m_info.m_modificationTime = reader.Read<int64_t>();
+		entry.m_info.m_hash = reader.Read<uint64_t>();
+		entry.m_size = reader.Read<uint32_t>();
+		entry.m_data = reader.Skip(entry.m_size);
+		m_entries[filePath] = entry;
+	}
+	EXPECT(reader.IsEnd());
+}
+
+void TournamentCache::AppendEntry(const string8_t& filePath, const LogFileInfo& info, const char* data, uint32_t size)
+{
+	AppendString(m_output, filePath);
+	Append(m_output, info.m_size);
+	Append(m_output, info.m_modificationTime);
+	Append(m_output, info.m_hash);
+	Append(m_output, size);
+	m_output.append(data, size);
+	++m_numOutputEntries;
+}
+
+vector<Tournament> ReadTournaments(const vector<string8_t>& filePaths, const string8_t& cacheFile)
+{
+	TournamentCache cache(cacheFile);
+
+	vector<Tournament> tournaments(filePaths.size());
+	vector<size_t> changedIndices;
+	vector<string8_t> changedFiles;
+	for (size_t i = 0; i < filePaths.size(); ++i)
+	{
+		if (!cache.Read(filePaths[i], tournaments[i]))
+		{
+			changedIndices.push_back(i);
+			changedFiles.push_back(filePaths[i]);
+		}
+	}
+
+	vector<Tournament> changedTournaments = ReadTournaments(changedFiles);
+	for (size_t i = 0; i < changedFiles.size(); ++i)
+	{
+		cache.Write(changedFiles[i], changedTournaments[i]);
+		tournaments[changedIndices[i]] = changedTournaments[i];
+	}
+
+	cache.Save();
+	return tournaments;
+}
+
+} // namespace ratings
+} // namespace my
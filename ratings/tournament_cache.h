@@ -0,0 +1,64 @@
+#ifndef _3575F415_7814_4E45_83CD_A4580BD6C8B1_
+#define _3575F415_7814_4E45_83CD_A4580BD6C8B1_
+
+#include "tournament.h"
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace my {
+namespace ratings {
+
+struct LogFileInfo
+{
+	uint64_t m_size;
+	int64_t m_modificationTime;
+	uint64_t m_hash;
+};
+
+// Binary cache of parsed tournament logs, memory-mapped on load.
+// An entry is reused while the log keeps its size and modification time, or its content hash when only the time changed.
+// Logs modified no earlier than the cache was saved are always hashed, as the time alone cannot tell those writes apart.
+class TournamentCache
+{
+public:
+	explicit TournamentCache(const string8_t& cacheFile);
+
+public:
+	bool Read(const string8_t& filePath, Tournament& tournament);
+	void Write(const string8_t& filePath, const Tournament& tournament);
+	void Save();
+
+private:
+	struct Entry
+	{
+		LogFileInfo m_info;
+		const char* m_data;
+		uint32_t m_size;
+	};
+
+private:
+	void Load();
+	void AppendEntry(const string8_t& filePath, const LogFileInfo& info, const char* data, uint32_t size);
+
+private:
+	const string8_t m_cacheFile;
+	boost::scoped_ptr<boost::interprocess::file_mapping> m_file;
+	boost::scoped_ptr<boost::interprocess::mapped_region> m_region;
+	boost::unordered_map<string8_t, Entry> m_entries;
+	int64_t m_savedTime;
+	string8_t m_output;
+	uint32_t m_numOutputEntries;
+	bool m_isChanged;
+};
+
+vector<Tournament> ReadTournaments(const vector<string8_t>& filePaths, const string8_t& cacheFile);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _3575F415_7814_4E45_83CD_A4580BD6C8B1_
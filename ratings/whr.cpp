@@ -0,0 +1,458 @@
+#include "whr.h"
+#include "history.h"
+#include "binary.h"
+#include <framework/rtl/expect.h>
+#include <framework/rtl/formatting.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace my {
+namespace ratings {
+namespace {
+
+const uint32_t MaxIterations = 10000;
+const double Tolerance = 0.000000001;
+const double Damping = 0.5;
+const int GradientDigitsAfterDot = 12;
+const uint32_t NoIndex = -1;
+
+// Ratings are natural Bradley-Terry ratings: P(A wins) = 1/(1 + exp(rB - rA)).
+// A point is the rating of one player in one tournament; points of a player are contiguous and ordered by time.
+// Every iteration makes one Newton step per player with the opponents fixed at the previous iteration,
+// so the result does not depend on the order of players. The engine fits its views in parallel, so one fit runs on one thread.
+// The steps are damped, because players who mostly meet each other would otherwise oscillate.
+// The fit stops once no rating has a gradient of the log-likelihood above Tolerance, which does not depend on the damping.
+class Solver
+{
+public:
+	explicit Solver(const vector<uint32_t>& pointsBegin, const vector<uint32_t>& pointTournaments, const vector<uint32_t>& gamesBegin,
+		const vector<uint32_t>& gameOpponents, const vector<double>& gameScores, const vector<double>& gameWeights, double variancePerTournament, vector<double>& ratings)
+		: m_pointsBegin(pointsBegin)
+		, m_pointTournaments(pointTournaments)
+		, m_gamesBegin(gamesBegin)
+		, m_gameOpponents(gameOpponents)
+		, m_gameScores(gameScores)
+		, m_gameWeights(gameWeights)
+		, m_variancePerTournament(variancePerTournament)
+		, m_ratings(ratings)
+		, m_newRatings(ratings)
+	{
+	}
+
+public:
+	uint32_t Run(double& maxGradient)
+	{
+		uint32_t numPlayers = m_pointsBegin.size() - 1;
+		vector<double> gradient, diagonal, offDiagonal;
+		for (uint32_t iteration = 0; iteration < MaxIterations; ++iteration)
+		{
+			maxGradient = 0;
+			for (PlayerId player = 0; player < numPlayers; ++player)
+			{
+				maxGradient = std::max(maxGradient, UpdatePlayer(m_pointsBegin[player], m_pointsBegin[player + 1], gradient, diagonal, offDiagonal));
+			}
+			if (maxGradient < Tolerance)
+				return iteration;
+			m_ratings.swap(m_newRatings);
+		}
+		return MaxIterations;
+	}
+
+private:
+
+	// Returns the largest gradient at the current ratings; the step is taken into m_newRatings.
+	double UpdatePlayer(uint32_t begin, uint32_t end, vector<double>& gradient, vector<double>& diagonal, vector<double>& offDiagonal)
+	{
+		uint32_t numPoints = end - begin;
+		if (numPoints == 0)
+			return 0;
+
+		gradient.assign(numPoints, 0);
+		diagonal.assign(numPoints, 0);
+		offDiagonal.assign(numPoints, 0);
+		for (uint32_t k = 0; k < numPoints; ++k)
+		{
+			double rating = m_ratings[begin + k];
+			for (uint32_t game = m_gamesBegin[begin + k]; game < m_gamesBegin[begin + k + 1]; ++game)
+			{
+				double p = 1./(1. + exp(m_ratings[m_gameOpponents[game]] - rating));
+				gradient[k] += m_gameWeights[game] * (m_gameScores[game] - p);
+				diagonal[k] -= m_gameWeights[game] * p * (1. - p);
+			}
+		}
+
+		// The first rating is anchored by one virtual win and one virtual loss against a zero rating.
+		double p = 1./(1. + exp(-m_ratings[begin]));
+		gradient[0] += 1. - 2. * p;
+		diagonal[0] -= 2. * p * (1. - p);
+
+		for (uint32_t k = 0; k + 1 < numPoints; ++k)
+		{
+			double inverseVariance = 1./(m_variancePerTournament * (m_pointTournaments[begin + k + 1] - m_pointTournaments[begin + k]));
+			double drift = (m_ratings[begin + k + 1] - m_ratings[begin + k]) * inverseVariance;
+			gradient[k] += drift;
+			gradient[k + 1] -= drift;
+			diagonal[k] -= inverseVariance;
+			diagonal[k + 1] -= inverseVariance;
+			offDiagonal[k] = inverseVariance;
+		}
+
+		double maxGradient = 0;
+		for (uint32_t k = 0; k < numPoints; ++k)
+		{
+			maxGradient = std::max(maxGradient, fabs(gradient[k]));
+		}
+
+		// Thomas algorithm for the tridiagonal Hessian; the step is -H^-1 * gradient.
+		for (uint32_t k = 1; k < numPoints; ++k)
+		{
+			double factor = offDiagonal[k - 1]/diagonal[k - 1];
+			diagonal[k] -= factor * offDiagonal[k - 1];
+			gradient[k] -= factor * gradient[k - 1];
+		}
+		double step = 0;
+		for (uint32_t k = numPoints; k-- > 0; )
+		{
+			step = (gradient[k] - offDiagonal[k] * step)/diagonal[k];
+			m_newRatings[begin + k] = m_ratings[begin + k] - Damping * step;
+		}
+		return maxGradient;
+	}
+
+private:
+	const vector<uint32_t>& m_pointsBegin;
+	const vector<uint32_t>& m_pointTournaments;
+	const vector<uint32_t>& m_gamesBegin;
+	const vector<uint32_t>& m_gameOpponents;
+	const vector<double>& m_gameScores;
+	const vector<double>& m_gameWeights;
+	const double m_variancePerTournament;
+	vector<double>& m_ratings;
+	vector<double> m_newRatings;
+};
+
+} // namespace
+
+class WhrSeason;
+
+class WhrTournament: public ITournament
+{
+public:
+	explicit WhrTournament(WhrSeason& season, const string8_t& name, uint32_t pointsPerMatch);
+
+public:
+	void AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB);
+	void End();
+
+private:
+	WhrSeason& m_season;
+	const string8_t m_name;
+	const uint32_t m_pointsPerMatch;
+	const uint32_t m_index;
+};
+
+// Matches are kept as two sides each: side 2*i is player A of match i, side 2*i + 1 is player B.
+// Update() fits the ratings and rebuilds the history whenever the season has changed since the last fit.
+class WhrSeason: public ISeason
+{
+	friend class WhrTournament;
+
+public:
+	explicit WhrSeason(const WhrSettings& settings, const PlayerRegistry& players)
+		: m_settings(settings)
+		, m_players(players)
+		, m_isSolved(false)
+	{
+	}
+
+public:
+	std::auto_ptr<ITournament> NewTournament(const string8_t& name, uint32_t pointsPerMatch)
+	{
+		return std::auto_ptr<ITournament>(new WhrTournament(*this, name, pointsPerMatch));
+	}
+
+	string8_t Update()
+	{
+		return m_isSolved ? string8_t() : Solve();
+	}
+
+	void DumpHistory(const string8_t& ratingFile, const string8_t& ratingHistoryFile, const string8_t& playersDir, HistoryLayout layout, IOutput& writer)
+	{
+		EXPECT(m_isSolved);
+		m_history->DumpHistory(ratingFile, ratingHistoryFile, playersDir, layout, writer);
+	}
+
+	vector<Rating> GetRatings() const
+	{
+		EXPECT(m_isSolved);
+		return m_history->GetRatings();
+	}
+
+	void DumpActiveRating(const string8_t& ratingFile, const vector<PlayerId>& activePlayers, uint32_t maxCount, IOutput& writer)
+	{
+		EXPECT(m_isSolved);
+		m_history->DumpActiveRating(ratingFile, activePlayers, maxCount, writer);
+	}
+
+	void Save(string8_t& output) const
+	{
+		Append(output, m_settings.m_startRating);
+		Append(output, m_settings.m_logisticRatingDenominator);
+		Append(output, m_settings.m_variancePerTournament);
+		Append(output, uint32_t(m_tournaments.size()));
+		BOOST_FOREACH(const string8_t& tournament, m_tournaments)
+		{
+			AppendString(output, tournament);
+		}
+		AppendVector(output, m_matchesEnd);
+		AppendVector(output, m_sidePlayers);
+		AppendVector(output, m_sidePoints);
+		AppendVector(output, m_sideScores);
+		AppendVector(output, m_matchWeights);
+		Append(output, uint32_t(m_pointTournaments.size()));
+		for (PlayerId player = 0; player < m_pointTournaments.size(); ++player)
+		{
+			AppendVector(output, m_pointTournaments[player]);
+		}
+	}
+
+	void Load(BinaryReader& reader)
+	{
+		EXPECT(reader.Read<double>() == m_settings.m_startRating);
+		EXPECT(reader.Read<double>() == m_settings.m_logisticRatingDenominator);
+		EXPECT(reader.Read<double>() == m_settings.m_variancePerTournament);
+		uint32_t numTournaments = reader.Read<uint32_t>();
+		m_tournaments.resize(numTournaments);
+		for (uint32_t i = 0; i < numTournaments; ++i)
+		{
+			m_tournaments[i] = reader.ReadString();
+		}
+		reader.ReadVector(m_matchesEnd);
+		reader.ReadVector(m_sidePlayers);
+		reader.ReadVector(m_sidePoints);
+		reader.ReadVector(m_sideScores);
+		reader.ReadVector(m_matchWeights);
+		uint32_t numPlayers = reader.Read<uint32_t>();
+		EXPECT(numPlayers <= m_players.GetCount());
+		m_pointTournaments.resize(numPlayers);
+		for (PlayerId player = 0; player < numPlayers; ++player)
+		{
+			reader.ReadVector(m_pointTournaments[player]);
+			for (uint32_t k = 0; k < m_pointTournaments[player].size(); ++k)
+			{
+				EXPECT(m_pointTournaments[player][k] < numTournaments && (k == 0 || m_pointTournaments[player][k - 1] < m_pointTournaments[player][k]));
+			}
+		}
+
+		EXPECT(m_matchesEnd.size() == numTournaments && (m_matchesEnd.empty() || m_matchesEnd.back() == m_matchWeights.size()));
+		EXPECT(m_sidePlayers.size() == 2 * m_matchWeights.size() && m_sidePoints.size() == m_sidePlayers.size() && m_sideScores.size() == m_sidePlayers.size());
+		for (uint32_t side = 0; side < m_sidePlayers.size(); ++side)
+		{
+			EXPECT(m_sidePlayers[side] < numPlayers && m_sidePoints[side] < m_pointTournaments[m_sidePlayers[side]].size());
+		}
+		m_isSolved = false;
+	}
+
+private:
+	string8_t Solve()
+	{
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		uint32_t numPlayers = m_pointTournaments.size();
+		uint32_t numRatedPlayers = 0;
+		vector<uint32_t> pointsBegin(numPlayers + 1, 0);
+		for (PlayerId player = 0; player < numPlayers; ++player)
+		{
+			pointsBegin[player + 1] = pointsBegin[player] + m_pointTournaments[player].size();
+			numRatedPlayers += (m_pointTournaments[player].empty() ? 0 : 1);
+		}
+		uint32_t numPoints = pointsBegin.back();
+		vector<uint32_t> pointTournaments;
+		pointTournaments.reserve(numPoints);
+		for (PlayerId player = 0; player < numPlayers; ++player)
+		{
+			pointTournaments.insert(pointTournaments.end(), m_pointTournaments[player].begin(), m_pointTournaments[player].end());
+		}
+
+		uint32_t numSides = m_sidePlayers.size();
+		vector<uint32_t> sideGlobalPoints(numSides);
+		vector<uint32_t> gamesBegin(numPoints + 1, 0);
+		for (uint32_t side = 0; side < numSides; ++side)
+		{
+			sideGlobalPoints[side] = pointsBegin[m_sidePlayers[side]] + m_sidePoints[side];
+			++gamesBegin[sideGlobalPoints[side] + 1];
+		}
+		for (uint32_t point = 0; point < numPoints; ++point)
+		{
+			gamesBegin[point + 1] += gamesBegin[point];
+		}
+		vector<uint32_t> gameOpponents(numSides);
+		vector<double> gameScores(numSides), gameWeights(numSides);
+		vector<uint32_t> nextGames(gamesBegin.begin(), gamesBegin.end() - 1);
+		for (uint32_t side = 0; side < numSides; ++side)
+		{
+			uint32_t game = nextGames[sideGlobalPoints[side]]++;
+			gameOpponents[game] = sideGlobalPoints[side ^ 1];
+			gameScores[game] = double(m_sideScores[side])/(m_sideScores[side] + m_sideScores[side ^ 1]);
+			gameWeights[game] = m_matchWeights[side / 2];
+		}
+
+		double scale = log(10.)/m_settings.m_logisticRatingDenominator;
+		// Every fit starts from zero ratings, so a season restored from a checkpoint fits to exactly the same ratings as one played in full.
+		vector<double> ratings(numPoints, 0.);
+		double maxGradient = 0;
+		Solver solver(pointsBegin, pointTournaments, gamesBegin, gameOpponents, gameScores, gameWeights, m_settings.m_variancePerTournament * scale * scale, ratings);
+		uint32_t numIterations = solver.Run(maxGradient);
+		RebuildHistory(pointsBegin, gamesBegin, gameWeights, sideGlobalPoints, ratings);
+		m_isSolved = true;
+
+		int64_t microseconds = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+		return ToString(numRatedPlayers) + " players, " + ToString(numPoints) + " ratings, " + ToString(numIterations) + " iterations, max gradient "
+			+ ToString(maxGradient, GradientDigitsAfterDot) + ", " + ToString(microseconds/1000000., StandartPrintDigitsAfterDot) + " s";
+	}
+
+	// Each side gets the change of its player in the tournament in proportion to the weight of the match.
+	void RebuildHistory(const vector<uint32_t>& pointsBegin, const vector<uint32_t>& gamesBegin, const vector<double>& gameWeights, const vector<uint32_t>& sideGlobalPoints, const vector<double>& ratings)
+	{
+		vector<double> pointWeights(ratings.size(), 0);
+		for (uint32_t point = 0; point < ratings.size(); ++point)
+		{
+			for (uint32_t game = gamesBegin[point]; game < gamesBegin[point + 1]; ++game)
+			{
+				pointWeights[point] += gameWeights[game];
+			}
+		}
+
+		m_history.reset(new HistoryStorage(m_players));
+		vector<uint32_t> lastTournaments(pointsBegin.size() - 1, NoIndex);
+		for (uint32_t index = 0; index < m_tournaments.size(); ++index)
+		{
+			HistoryStorage::Tournament tournament(*m_history, m_tournaments[index]);
+			vector<Rating> changes;
+			uint32_t matchesBegin = (index == 0 ? 0 : m_matchesEnd[index - 1]);
+			for (uint32_t match = matchesBegin; match < m_matchesEnd[index]; ++match)
+			{
+				double previous[2];
+				double change[2];
+				for (uint32_t i = 0; i < 2; ++i)
+				{
+					uint32_t side = 2 * match + i;
+					PlayerId player = m_sidePlayers[side];
+					uint32_t point = sideGlobalPoints[side];
+					double rating = ToRating(ratings[point]);
+					previous[i] = (point == pointsBegin[player] ? m_settings.m_startRating : ToRating(ratings[point - 1]));
+					change[i] = (rating - previous[i]) * m_matchWeights[match]/pointWeights[point];
+					if (lastTournaments[player] != index)
+					{
+						lastTournaments[player] = index;
+						Rating changed;
+						changed.player = player;
+						changed.value = rating;
+						changes.push_back(changed);
+					}
+				}
+				tournament.AddMatch(m_sidePlayers[2 * match], m_sidePlayers[2 * match + 1], m_sideScores[2 * match], m_sideScores[2 * match + 1], previous[0], previous[1], change[0], change[1]);
+			}
+			tournament.End(changes);
+		}
+	}
+
+	uint32_t GetPoint(PlayerId player, uint32_t tournament)
+	{
+		if (player >= m_pointTournaments.size())
+		{
+			m_pointTournaments.resize(player + 1);
+		}
+		vector<uint32_t>& tournaments = m_pointTournaments[player];
+		if (tournaments.empty() || tournaments.back() != tournament)
+		{
+			tournaments.push_back(tournament);
+		}
+		return tournaments.size() - 1;
+	}
+
+	double ToRating(double rating) const
+	{
+		return m_settings.m_startRating + rating * m_settings.m_logisticRatingDenominator/log(10.);
+	}
+
+private:
+	const WhrSettings m_settings;
+	const PlayerRegistry& m_players;
+	boost::scoped_ptr<HistoryStorage> m_history;
+	vector<string8_t> m_tournaments;
+	vector<uint32_t> m_matchesEnd;
+	vector<PlayerId> m_sidePlayers;
+	vector<uint32_t> m_sidePoints;
+	vector<uint32_t> m_sideScores;
+	vector<double> m_matchWeights;
+	vector<vector<uint32_t> > m_pointTournaments;
+	bool m_isSolved;
+};
+
+WhrTournament::WhrTournament(WhrSeason& season, const string8_t& name, uint32_t pointsPerMatch)
+	: m_season(season)
+	, m_name(name)
+	, m_pointsPerMatch(pointsPerMatch)
+	, m_index(season.m_tournaments.size())
+{
+}
+
+void WhrTournament::AddMatch(PlayerId playerA, PlayerId playerB, uint32_t scoreA, uint32_t scoreB)
+{
+	m_season.m_sidePlayers.push_back(playerA);
+	m_season.m_sidePlayers.push_back(playerB);
+	m_season.m_sidePoints.push_back(m_season.GetPoint(playerA, m_index));
+	m_season.m_sidePoints.push_back(m_season.GetPoint(playerB, m_index));
+	m_season.m_sideScores.push_back(scoreA);
+	m_season.m_sideScores.push_back(scoreB);
+	m_season.m_matchWeights.push_back(double(scoreA + scoreB)/m_pointsPerMatch);
+}
+
+void WhrTournament::End()
+{
+	EXPECT(m_index == m_season.m_tournaments.size());
+	m_season.m_tournaments.push_back(m_name);
+	m_season.m_matchesEnd.push_back(m_season.m_matchWeights.size());
+	m_season.m_isSolved = false;
+}
+
+class WhrSystem: public ISystem
+{
+public:
+	explicit WhrSystem(const WhrSettings& settings) : m_settings(settings) { }
+
+public:
+	std::auto_ptr<ISeason> NewSeason(const PlayerRegistry& players)
+	{
+		return std::auto_ptr<ISeason>(new WhrSeason(m_settings, players));
+	}
+
+private:
+	const WhrSettings m_settings;
+};
+
+std::auto_ptr<ISystem> CreateWhrSystem(const WhrSettings& settings)
+{
+	return std::auto_ptr<ISystem>(new WhrSystem(settings));
+}
+
+WhrSettings::WhrSettings(double startRating, double logisticRatingDenominator, double variancePerTournament)
+	: m_startRating(startRating)
+	, m_logisticRatingDenominator(logisticRatingDenominator)
+	, m_variancePerTournament(variancePerTournament)
+{
+	EXPECT(m_startRating > 0);
+	EXPECT(m_logisticRatingDenominator > 0);
+	EXPECT(m_variancePerTournament > 0);
+}
+
+WhrSettings StandartWhrSettings()
+{
+	return WhrSettings(1500, 400, 300);
+}
+
+} // namespace ratings
+} // namespace my
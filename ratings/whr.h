@@ -0,0 +1,27 @@
+#ifndef _56462A3C_FE80_4B45_82D1_D5BD986EC40B_
+#define _56462A3C_FE80_4B45_82D1_D5BD986EC40B_
+
+#include "system.h"
+
+namespace my {
+namespace ratings {
+
+// Whole-History Rating: every player has a rating per tournament played, and all of them are fitted together
+// when the season is dumped. Time is counted in tournaments of the season.
+struct WhrSettings
+{
+	WhrSettings(double startRating, double logisticRatingDenominator, double variancePerTournament);
+
+	double m_startRating;
+	double m_logisticRatingDenominator;
+	double m_variancePerTournament;
+};
+
+WhrSettings StandartWhrSettings();
+
+std::auto_ptr<ISystem> CreateWhrSystem(const WhrSettings& settings);
+
+} // namespace ratings
+} // namespace my
+
+#endif // _56462A3C_FE80_4B45_82D1_D5BD986EC40B_
@@ -0,0 +1,291 @@
+#include "xml_reader.h"
+#include <framework/rtl/expect.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace my {
+namespace ratings {
+namespace {
+
+bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool IsNameEnd(char c)
+{
+	return IsSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+void AppendUtf8(uint32_t codePoint, string8_t& text)
+{
+	if (codePoint < 0x80)
+	{
+		text += char(codePoint);
+	}
+	else if (codePoint < 0x800)
+	{
+		text += char(0xC0 | (codePoint >> 6));
+		text += char(0x80 | (codePoint & 0x3F));
+	}
+	else if (codePoint < 0x10000)
+	{
+		text += char(0xE0 | (codePoint >> 12));
+		text += char(0x80 | ((codePoint >> 6) & 0x3F));
+		text += char(0x80 | (codePoint & 0x3F));
+	}
+	else
+	{
+		EXPECT(codePoint < 0x110000);
+		text += char(0xF0 | (codePoint >> 18));
+		text += char(0x80 | ((codePoint >> 12) & 0x3F));
+		text += char(0x80 | ((codePoint >> 6) & 0x3F));
+		text += char(0x80 | (codePoint & 0x3F));
+	}
+}
+
+} // namespace
+
+XmlReader::XmlReader(const char* begin, const char* end)
+	: m_current(begin)
+	, m_end(end)
+	, m_isEmptyElement(false)
+	, m_depth(0)
+{
+	if (StartsWith("\xEF\xBB\xBF"))
+	{
+		m_current += 3;
+	}
+}
+
+bool XmlReader::ReadStartElement()
+{
+	if (m_isEmptyElement)
+	{
+		m_isEmptyElement = false;
+		return false;
+	}
+
+	for (;;)
+	{
+		while (m_current != m_end && *m_current != '<')
+		{
+			++m_current;
+		}
+		EXPECT(m_current != m_end);
+
+		if (StartsWith("<?"))
+		{
+			SkipPast("?>");
+		}
+		else if (StartsWith("<!--"))
+		{
+			SkipPast("-->");
+		}
+		else if (StartsWith("<![CDATA["))
+		{
+			SkipPast("]]>");
+		}
+		else if (StartsWith("<!"))
+		{
+			SkipPast(">");
+		}
+		else if (StartsWith("</"))
+		{
+			ReadEndTag();
+			return false;
+		}
+		else
+		{
+			ReadStartTag();
+			return true;
+		}
+	}
+}
+
+const string8_t& XmlReader::ReadText()
+{
+	m_text.clear();
+	if (m_isEmptyElement)
+	{
+		m_isEmptyElement = false;
+		return m_text;
+	}
+
+	for (;;)
+	{
+		const char* chunk = m_current;
+		while (m_current != m_end && *m_current != '<' && *m_current != '&')
+		{
+			++m_current;
+		}
+		m_text.append(chunk, m_current);
+		EXPECT(m_current != m_end);
+
+		if (*m_current == '&')
+		{
+			ReadEntity();
+		}
+		else if (StartsWith("<![CDATA["))
+		{
+			const char* data = m_current + strlen("<![CDATA[");
+			SkipPast("]]>");
+			m_text.append(data, m_current - strlen("]]>"));
+		}
+		else if (StartsWith("<!--"))
+		{
+			SkipPast("-->");
+		}
+		else
+		{
+			EXPECT(StartsWith("</"));
+			ReadEndTag();
+			return m_text;
+		}
+	}
+}
+
+void XmlReader::SkipElement()
+{
+	while (ReadStartElement())
+	{
+		SkipElement();
+	}
+}
+
+const string8_t& XmlReader::GetName() const
+{
+	return m_name;
+}
+
+void XmlReader::ReadStartTag()
+{
+	++m_current;
+	const char* name = m_current;
+	while (m_current != m_end && !IsNameEnd(*m_current))
+	{
+		++m_current;
+	}
+	EXPECT(m_current != name);
+	m_name.assign(name, m_current);
+
+	for (;;)
+	{
+		while (m_current != m_end && IsSpace(*m_current))
+		{
+			++m_current;
+		}
+		EXPECT(m_current != m_end);
+
+		if (*m_current == '>')
+		{
+			++m_current;
+			break;
+		}
+		if (StartsWith("/>"))
+		{
+			m_current += 2;
+			m_isEmptyElement = true;
+			return;
+		}
+
+		while (m_current != m_end && *m_current != '=')
+		{
+			++m_current;
+		}
+		EXPECT(m_current != m_end);
+		++m_current;
+		while (m_current != m_end && IsSpace(*m_current))
+		{
+			++m_current;
+		}
+		EXPECT(m_current != m_end && (*m_current == '"' || *m_current == '\''));
+		char quote = *m_current;
+		++m_current;
+		while (m_current != m_end && *m_current != quote)
+		{
+			++m_current;
+		}
+		EXPECT(m_current != m_end);
+		++m_current;
+	}
+
+	if (m_depth == m_elements.size())
+	{
+		m_elements.push_back(string8_t());
+	}
+	m_elements[m_depth].assign(m_name);
+	++m_depth;
+}
+
+void XmlReader::ReadEndTag()
+{
+	m_current += 2;
+	const char* name = m_current;
+	while (m_current != m_end && !IsNameEnd(*m_current))
+	{
+		++m_current;
+	}
+	EXPECT(m_depth > 0);
+	const string8_t& openName = m_elements[m_depth - 1];
+	EXPECT(openName.size() == size_t(m_current - name) && std::equal(name, m_current, openName.begin()));
+	--m_depth;
+
+	while (m_current != m_end && IsSpace(*m_current))
+	{
+		++m_current;
+	}
+	EXPECT(m_current != m_end && *m_current == '>');
+	++m_current;
+}
+
+void XmlReader::ReadEntity()
+{
+	const char* name = m_current + 1;
+	const char* end = name;
+	while (end != m_end && *end != ';')
+	{
+		++end;
+	}
+	EXPECT(end != m_end);
+	string8_t entity(name, end);
+	m_current = end + 1;
+
+	if (entity == "amp")
+		m_text += '&';
+	else if (entity == "lt")
+		m_text += '<';
+	else if (entity == "gt")
+		m_text += '>';
+	else if (entity == "quot")
+		m_text += '"';
+	else if (entity == "apos")
+		m_text += '\'';
+	else
+	{
+		EXPECT(entity.size() > 1 && entity[0] == '#');
+		bool isHex = (entity[1] == 'x' || entity[1] == 'X');
+		char* numberEnd = 0;
+		unsigned long codePoint = strtoul(entity.c_str() + (isHex ? 2 : 1), &numberEnd, isHex ? 16 : 10);
+		EXPECT(numberEnd == entity.c_str() + entity.size());
+		AppendUtf8(uint32_t(codePoint), m_text);
+	}
+}
+
+void XmlReader::SkipPast(const char* terminator)
+{
+	size_t length = strlen(terminator);
+	const char* it = std::search(m_current, m_end, terminator, terminator + length);
+	EXPECT(it != m_end);
+	m_current = it + length;
+}
+
+bool XmlReader::StartsWith(const char* prefix) const
+{
+	size_t length = strlen(prefix);
+	return size_t(m_end - m_current) >= length && std::equal(prefix, prefix + length, m_current);
+}
+
+} // namespace ratings
+} // namespace my
@@ -0,0 +1,46 @@
+#ifndef _2570D42A_3D9A_45EC_A042_79CBB5D0EF01_
+#define _2570D42A_3D9A_45EC_A042_79CBB5D0EF01_
+
+#include <framework/types/string.h>
+#include <framework/types/vector.h>
+#include <framework/types/types.h>
+
+namespace my {
+namespace ratings {
+
+// Forward-only reader over an in-memory XML document.
+// ReadStartElement() enters the next child of the current element and returns false once the current element is closed.
+// An entered element has to be finished with ReadText(), SkipElement() or by reading its children until ReadStartElement() returns false.
+class XmlReader
+{
+public:
+	XmlReader(const char* begin, const char* end);
+
+public:
+	bool ReadStartElement();
+	const string8_t& ReadText();
+	void SkipElement();
+
+	const string8_t& GetName() const;
+
+private:
+	void ReadStartTag();
+	void ReadEndTag();
+	void ReadEntity();
+	void SkipPast(const char* terminator);
+	bool StartsWith(const char* prefix) const;
+
+private:
+	const char* m_current;
+	const char* const m_end;
+	bool m_isEmptyElement;
+	string8_t m_name;
+	string8_t m_text;
+	vector<string8_t> m_elements;
+	size_t m_depth;
+};
+
+} // namespace ratings
+} // namespace my
+
+#endif // _2570D42A_3D9A_45EC_A042_79CBB5D0EF01_